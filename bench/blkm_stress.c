@@ -0,0 +1,200 @@
+// Random alloc/free stress of the buddy frame allocator. Every block is tagged frame by frame
+// so overlapping blocks are caught, the latency of both calls is measured, the fragmentation
+// is sampled along the way and everything has to coalesce back once the blocks are freed
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "host.h"
+#include "mm/memory.h"
+#include "common/system.h"
+#include "mm/blkm/blkm.h"
+
+#define BLKM_STRESS_OPS 3000000
+#define BLKM_STRESS_SAMPLES 6
+#define BLKM_STRESS_MAX_LIVE 4096
+// Mostly page tables and slabs, 1 to 16 frames, and now and then a large buffer
+#define BLKM_STRESS_MAX_FRAMES 16
+#define BLKM_STRESS_LARGE_FRAMES 256
+
+struct blkm_stress_block_t
+{
+  uint32_t *ptr;
+  uint32_t frames;
+  uint32_t tag;
+};
+
+static struct blkm_stress_block_t live[BLKM_STRESS_MAX_LIVE];
+static int total_live = 0;
+
+static void blkm_stress_tag(struct blkm_stress_block_t *block)
+{
+  for (uint32_t i = 0; i < block->frames; i++)
+  {
+    block->ptr[i * (BLKM_FRAME_SIZE / sizeof(uint32_t))] = block->tag;
+  }
+}
+
+static bool blkm_stress_check(struct blkm_stress_block_t *block)
+{
+  for (uint32_t i = 0; i < block->frames; i++)
+  {
+    if (block->ptr[i * (BLKM_FRAME_SIZE / sizeof(uint32_t))] != block->tag)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static int blkm_stress_largest_order(struct blkm_stats_t *stats)
+{
+  for (int order = BLKM_MAX_ORDER; order >= 0; order--)
+  {
+    if (stats->free_blocks[order])
+    {
+      return order;
+    }
+  }
+
+  return -1;
+}
+
+// A failed allocation is only fine when no free block is large enough
+static bool blkm_stress_failure_allowed(uint32_t frames)
+{
+  struct blkm_stats_t stats;
+  mem_stats(&stats);
+  int largest = blkm_stress_largest_order(&stats);
+  return largest < 0 || (1U << largest) < frames;
+}
+
+static int blkm_stress_run(uint8_t *pool, size_t size, uint32_t seed)
+{
+  struct blkm_stats_t initial;
+  mem_init(pool, size);
+  mem_stats(&initial);
+  total_live = 0;
+
+  printf("blkm_stress: %u frames, seed 0x%x\n", initial.total_frames, seed);
+  printf("%10s %10s %10s %10s %10s %10s %10s %8s\n", "ops", "allocs", "alloc ns", "max ns", "frees", "free ns", "free", "largest");
+
+  uint64_t alloc_ns = 0, alloc_max = 0, free_ns = 0;
+  uint32_t allocs = 0, frees = 0;
+  uint32_t next_tag = 1;
+  for (int op = 1; op <= BLKM_STRESS_OPS; op++)
+  {
+    // Lean towards allocating so the pool runs close to full and fragments
+    bool grow = total_live < BLKM_STRESS_MAX_LIVE && (total_live == 0 || host_random(&seed) % 100 < 52);
+    if (grow)
+    {
+      uint32_t frames = 1 + host_random(&seed) % BLKM_STRESS_MAX_FRAMES;
+      if (host_random(&seed) % 64 == 0)
+      {
+        frames = 1 + host_random(&seed) % BLKM_STRESS_LARGE_FRAMES;
+      }
+
+      uint64_t start = host_now_ns();
+      uint32_t *ptr = mem_alloc(frames * BLKM_FRAME_SIZE);
+      uint64_t elapsed = host_now_ns() - start;
+      if (!ptr)
+      {
+        if (!blkm_stress_failure_allowed(frames))
+        {
+          printf("FAIL: a %u frame allocation failed with a large enough block free\n", frames);
+          return 1;
+        }
+
+        continue;
+      }
+
+      if ((uint8_t *)ptr < pool || (uint8_t *)ptr + frames * BLKM_FRAME_SIZE > pool + initial.total_frames * BLKM_FRAME_SIZE)
+      {
+        printf("FAIL: block %p is outside the pool\n", (void *)ptr);
+        return 1;
+      }
+
+      struct blkm_stress_block_t *block = &live[total_live++];
+      block->ptr = ptr;
+      block->frames = frames;
+      block->tag = next_tag++;
+      blkm_stress_tag(block);
+
+      alloc_ns += elapsed;
+      alloc_max = elapsed > alloc_max ? elapsed : alloc_max;
+      allocs++;
+    }
+    else
+    {
+      int index = host_random(&seed) % total_live;
+      if (!blkm_stress_check(&live[index]))
+      {
+        printf("FAIL: block %p was overwritten, two blocks overlap\n", (void *)live[index].ptr);
+        return 1;
+      }
+
+      uint64_t start = host_now_ns();
+      mem_free(live[index].ptr);
+      free_ns += host_now_ns() - start;
+      live[index] = live[--total_live];
+      frees++;
+    }
+
+    if (op % (BLKM_STRESS_OPS / BLKM_STRESS_SAMPLES) == 0)
+    {
+      struct blkm_stats_t stats;
+      mem_stats(&stats);
+      printf("%10d %10u %10llu %10llu %10u %10llu %10u %8d\n", op, allocs,
+             (unsigned long long)(allocs ? alloc_ns / allocs : 0), (unsigned long long)alloc_max,
+             frees, (unsigned long long)(frees ? free_ns / frees : 0), stats.free_frames, blkm_stress_largest_order(&stats));
+      alloc_ns = alloc_max = free_ns = 0;
+      allocs = frees = 0;
+    }
+  }
+
+  while (total_live > 0)
+  {
+    struct blkm_stress_block_t *block = &live[--total_live];
+    if (!blkm_stress_check(block))
+    {
+      printf("FAIL: block %p was overwritten, two blocks overlap\n", (void *)block->ptr);
+      return 1;
+    }
+
+    mem_free(block->ptr);
+  }
+
+  // With everything freed the pool has to be carved exactly as it was at the start
+  struct blkm_stats_t stats;
+  mem_stats(&stats);
+  for (int order = 0; order < BLKM_TOTAL_ORDERS; order++)
+  {
+    if (stats.free_blocks[order] != initial.free_blocks[order] || stats.free_frames != initial.free_frames)
+    {
+      printf("FAIL: %u of %u frames free after freeing everything, the blocks did not coalesce\n", stats.free_frames, initial.free_frames);
+      return 1;
+    }
+  }
+
+  printf("blkm_stress: every block coalesced back\n");
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t seed = argc > 1 ? (uint32_t)strtoul(argv[1], 0, 0) : 0x9E3779B9;
+  uint8_t *pool = host_aligned_alloc(BLKM_FRAME_SIZE, BLKM_SIZE_BYTES);
+  if (!pool)
+  {
+    fprintf(stderr, "blkm_stress: out of memory\n");
+    return 1;
+  }
+
+  // The full pool, then one cut short to the installed memory the way a 128MB machine has it
+  if (blkm_stress_run(pool, BLKM_SIZE_BYTES, seed) || blkm_stress_run(pool, BLKM_SIZE_BYTES - BLKM_FIRMWARE_RESERVE_BYTES, seed))
+  {
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,124 @@
+// Allocation latency of the kernel heap as it fills up. The heap keeps its free extents in
+// size buckets, so a malloc should cost the same with the heap 10% full as with it 90% full
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "host.h"
+#include "mm/memory.h"
+#include "mm/heap/heap.h"
+
+#define HEAP_BENCH_LEVELS 9
+#define HEAP_BENCH_OPS_PER_LEVEL 200000
+#define HEAP_BENCH_MAX_LIVE 16384
+// Requests are 1 to 16 blocks, small kernel_malloc sizes are served by the slab classes instead
+#define HEAP_BENCH_MAX_BLOCKS 16
+
+struct heap_bench_allocation_t
+{
+  void *ptr;
+  uint32_t blocks;
+};
+
+static struct heap_bench_allocation_t live[HEAP_BENCH_MAX_LIVE];
+static int total_live = 0;
+static uint32_t used_blocks = 0;
+
+// What one pair of clock reads costs, taken off every measured operation
+static uint64_t heap_bench_clock_overhead()
+{
+  uint64_t best = ~0ULL;
+  for (int i = 0; i < 1000; i++)
+  {
+    uint64_t start = host_now_ns();
+    uint64_t elapsed = host_now_ns() - start;
+    if (elapsed < best)
+    {
+      best = elapsed;
+    }
+  }
+
+  return best;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t seed = argc > 1 ? (uint32_t)strtoul(argv[1], 0, 0) : 0x12345678;
+  uint32_t total_blocks = HEAP_SIZE_BYTES / HEAP_BLOCK_SIZE;
+
+  struct heap_t heap;
+  struct heap_table_t table = {.entries = malloc(total_blocks), .total = total_blocks};
+  char *memory = host_aligned_alloc(HEAP_BLOCK_SIZE, HEAP_SIZE_BYTES);
+  if (!table.entries || !memory)
+  {
+    fprintf(stderr, "heap_bench: out of memory\n");
+    return 1;
+  }
+
+  // Fault the pages in first so the host's page faults stay out of the numbers
+  memset(memory, 0, HEAP_SIZE_BYTES);
+  if (heap_create(&heap, memory, memory + HEAP_SIZE_BYTES, &table) < 0)
+  {
+    fprintf(stderr, "heap_bench: failed to create the heap\n");
+    return 1;
+  }
+
+  uint64_t overhead = heap_bench_clock_overhead();
+  printf("heap_bench: %u blocks of %u bytes, seed 0x%x\n", total_blocks, HEAP_BLOCK_SIZE, seed);
+  printf("%6s %10s %10s %10s %10s %10s %10s\n", "fill", "mallocs", "failed", "malloc ns", "max ns", "frees", "free ns");
+
+  // Churn around every fill level: allocate while below it, free a random allocation while above it
+  for (int level = 1; level <= HEAP_BENCH_LEVELS; level++)
+  {
+    uint32_t target = (uint64_t)total_blocks * level / 10;
+    uint64_t malloc_ns = 0, malloc_max = 0, free_ns = 0;
+    uint32_t mallocs = 0, failed = 0, frees = 0;
+
+    for (int op = 0; op < HEAP_BENCH_OPS_PER_LEVEL; op++)
+    {
+      bool grow = used_blocks < target && total_live < HEAP_BENCH_MAX_LIVE;
+      if (!grow && total_live == 0)
+      {
+        break;
+      }
+
+      if (grow)
+      {
+        uint32_t blocks = 1 + host_random(&seed) % HEAP_BENCH_MAX_BLOCKS;
+        uint64_t start = host_now_ns();
+        void *ptr = heap_malloc(&heap, blocks * HEAP_BLOCK_SIZE);
+        uint64_t elapsed = host_now_ns() - start;
+        elapsed = elapsed > overhead ? elapsed - overhead : 0;
+        if (!ptr)
+        {
+          // Too fragmented for this size, the free below makes room again
+          failed++;
+          continue;
+        }
+
+        live[total_live].ptr = ptr;
+        live[total_live].blocks = blocks;
+        total_live++;
+        used_blocks += blocks;
+        malloc_ns += elapsed;
+        malloc_max = elapsed > malloc_max ? elapsed : malloc_max;
+        mallocs++;
+        continue;
+      }
+
+      int index = host_random(&seed) % total_live;
+      uint64_t start = host_now_ns();
+      heap_free(&heap, live[index].ptr);
+      uint64_t elapsed = host_now_ns() - start;
+      free_ns += elapsed > overhead ? elapsed - overhead : 0;
+      used_blocks -= live[index].blocks;
+      live[index] = live[--total_live];
+      frees++;
+    }
+
+    printf("%5d%% %10u %10u %10llu %10llu %10u %10llu\n", level * 10, mallocs, failed,
+           (unsigned long long)(mallocs ? malloc_ns / mallocs : 0), (unsigned long long)malloc_max,
+           frees, (unsigned long long)(frees ? free_ns / frees : 0));
+  }
+
+  return 0;
+}
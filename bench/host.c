@@ -0,0 +1,20 @@
+// Stand-ins for the kernel services the allocators call, so they build as host programs
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+void panic(const char *message, const char *file, uint32_t line)
+{
+  fprintf(stderr, "PANIC(%s) at %s : %u\n", message, file, line);
+  exit(1);
+}
+
+// The CMOS is only read for the installed memory size, which the host programs never ask for
+uint8_t read_byte(uint16_t port)
+{
+  return 0;
+}
+
+void write_byte(uint16_t port, uint8_t value)
+{
+}
@@ -0,0 +1,33 @@
+#ifndef BENCH_HOST_H
+#define BENCH_HOST_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+static inline uint64_t host_now_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// xorshift, the runs are reproducible from their seed
+static inline uint32_t host_random(uint32_t *state)
+{
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+// Memory aligned the way the kernel hands it to the allocators
+static inline void *host_aligned_alloc(size_t alignment, size_t size)
+{
+  void *ptr = 0;
+  return posix_memalign(&ptr, alignment, size) == 0 ? ptr : 0;
+}
+
+#endif
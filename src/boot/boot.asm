@@ -93,7 +93,7 @@ gdt_descriptor:
 [BITS 32]
 load_kernel:
     mov eax, 1 ; Start reading from sector 1 because sector 2 is used for the bootloader
-    mov ecx, 100 ; Number of sectors to load
+    mov ecx, 199 ; Number of sectors to load (everything up to the end of the FAT reserved sectors)
     mov edi, 0x0100000 ; Destination address in memory to load the sectors
     call ata_lba_read ; Call the function to read sectors using ATA LBA (Logical Block Addressing) method
     jmp CODE_SEG:0x0100000 ; Jump to the loaded code(the kernel) at memory address 0x0100000
@@ -28,14 +28,48 @@ void panic(const char *message, const char *file, uint32_t line);
 
 #define TOTAL_INTERRUPTS 512
 
-// 100MB heap size
-#define HEAP_SIZE_BYTES 104857600
+// 48MB heap size
+#define HEAP_SIZE_BYTES 50331648
 #define HEAP_BLOCK_SIZE 4096
 #define HEAP_ADDRESS 0x01000000
 #define HEAP_TABLE_ADDRESS 0x00007E00
 
+// Up to 64MB of physical frames right after the heap, managed by the buddy allocator.
+// The pool is cut short to the installed memory, so the kernel needs at least
+// BLKM_ADDRESS + BLKM_MIN_SIZE_BYTES + BLKM_FIRMWARE_RESERVE_BYTES (73MB) of RAM
+#define BLKM_ADDRESS 0x04000000
+#define BLKM_SIZE_BYTES 67108864
+#define BLKM_MIN_SIZE_BYTES (8 * M)
+// The firmware keeps its ACPI tables at the top of memory, the pool stays clear of them
+#define BLKM_FIRMWARE_RESERVE_BYTES (1 * M)
+
+// Everything the kernel touches lives below this address, it is identity mapped in every page directory
+#define PAGING_IDENTITY_MAP_END 0x08000000
+
+// Link the kernel page tables into every task directory instead of building a private identity map
+#define PAGING_SHARED_KERNEL_TABLES 1
+
+// Identity map the kernel with 4MB pages when the processor supports PSE
+#define PAGING_KERNEL_LARGE_PAGES 1
+
 #define SECTOR_SIZE 512
 
+// Sectors kept in the disk block cache and the hash buckets used to find them, the bucket count is a power of two
+#define DISK_CACHE_BLOCKS 128
+#define DISK_CACHE_HASH_BUCKETS 64
+
+// Most sectors a disk stream reads with one command, the ATA sector count register holds 8 bits
+#define DISK_STREAM_MAX_SECTORS 128
+
+// Disks that can be registered, the boot disk is always disk 0
+#define MAX_DISKS 4
+
+// PCI functions remembered by the boot time bus scan
+#define PCI_MAX_DEVICES 64
+
+// Time PIO against bus master DMA reads of the boot disk while booting. Set to 0 to compile it out
+#define ATA_BOOT_BENCHMARK 1
+
 #define MAX_FILESYSTEMS 12
 #define MAX_FILE_DESCRIPTORS 512
 
@@ -50,12 +84,31 @@ void panic(const char *message, const char *file, uint32_t line);
 
 #define MAX_PROGRAM_ALLOCATIONS 1024
 #define MAX_PROCESSES 12
+#define MAX_COMMAND_ARGUMENTS 16
 
 #define USER_DATA_SEGMENT 0x23
 #define USER_CODE_SEGMENT 0x1B
 
 #define MAX_ISR80H_COMMANDS 1024
 
+// Count the calls and TSC cycles of every syscall, globally and per process. Set to 0 to compile it out
+#define ISR80H_SYSCALL_STATS 1
+#define ISR80H_STATS_MAX_COMMANDS 32
+
+// Rate of the PIT clock interrupt that drives the scheduler
+#define TIMER_FREQUENCY_HZ 1000
+
+// Mask the clock interrupt while the idle task halts, only device interrupts wake it up
+#define TASK_TICKLESS_IDLE 1
+
+// Every task, the idle one included, enters the kernel on a stack of its own so it can sleep in there
+#define TASK_KERNEL_STACK_SIZE 16384
+
+// Model specific registers used by SYSENTER
+#define IA32_SYSENTER_CS 0x174
+#define IA32_SYSENTER_ESP 0x175
+#define IA32_SYSENTER_EIP 0x176
+
 #define KEYBOARD_BUFFER_SIZE 1024
 
 #define ALL_OK 0
@@ -0,0 +1,195 @@
+#include <disk/cache.h>
+#include <common/system.h>
+#include <kernel/kernel.h>
+#include <mm/heap/kernel_heap.h>
+#include <mm/memory.h>
+
+static struct disk_cache_block_t disk_cache_blocks[DISK_CACHE_BLOCKS];
+static struct disk_cache_block_t *disk_cache_buckets[DISK_CACHE_HASH_BUCKETS];
+
+// The LRU list, blocks are evicted from the tail
+static struct disk_cache_block_t *disk_cache_lru_head = 0;
+static struct disk_cache_block_t *disk_cache_lru_tail = 0;
+
+static struct disk_cache_stats_t disk_cache_counters;
+
+static unsigned int disk_cache_hash(struct disk_t *disk, unsigned int lba)
+{
+  return (lba ^ ((unsigned int)disk->id * 0x9E3779B1)) & (DISK_CACHE_HASH_BUCKETS - 1);
+}
+
+static void disk_cache_lru_remove(struct disk_cache_block_t *block)
+{
+  if (block->lru_prev)
+  {
+    block->lru_prev->lru_next = block->lru_next;
+  }
+  else
+  {
+    disk_cache_lru_head = block->lru_next;
+  }
+
+  if (block->lru_next)
+  {
+    block->lru_next->lru_prev = block->lru_prev;
+  }
+  else
+  {
+    disk_cache_lru_tail = block->lru_prev;
+  }
+
+  block->lru_prev = 0;
+  block->lru_next = 0;
+}
+
+static void disk_cache_lru_push_head(struct disk_cache_block_t *block)
+{
+  block->lru_prev = 0;
+  block->lru_next = disk_cache_lru_head;
+  if (disk_cache_lru_head)
+  {
+    disk_cache_lru_head->lru_prev = block;
+  }
+  else
+  {
+    disk_cache_lru_tail = block;
+  }
+
+  disk_cache_lru_head = block;
+}
+
+static void disk_cache_lru_push_tail(struct disk_cache_block_t *block)
+{
+  block->lru_next = 0;
+  block->lru_prev = disk_cache_lru_tail;
+  if (disk_cache_lru_tail)
+  {
+    disk_cache_lru_tail->lru_next = block;
+  }
+  else
+  {
+    disk_cache_lru_head = block;
+  }
+
+  disk_cache_lru_tail = block;
+}
+
+static void disk_cache_hash_remove(struct disk_cache_block_t *block)
+{
+  struct disk_cache_block_t **link = &disk_cache_buckets[disk_cache_hash(block->disk, block->lba)];
+  while (*link)
+  {
+    if (*link == block)
+    {
+      *link = block->hash_next;
+      break;
+    }
+
+    link = &(*link)->hash_next;
+  }
+
+  block->hash_next = 0;
+}
+
+static struct disk_cache_block_t *disk_cache_find(struct disk_t *disk, unsigned int lba)
+{
+  for (struct disk_cache_block_t *block = disk_cache_buckets[disk_cache_hash(disk, lba)]; block; block = block->hash_next)
+  {
+    if (block->disk == disk && block->lba == lba)
+    {
+      return block;
+    }
+  }
+
+  return 0;
+}
+
+void disk_cache_init()
+{
+  memset(disk_cache_blocks, 0, sizeof(disk_cache_blocks));
+  memset(disk_cache_buckets, 0, sizeof(disk_cache_buckets));
+  memset(&disk_cache_counters, 0, sizeof(disk_cache_counters));
+  disk_cache_lru_head = 0;
+  disk_cache_lru_tail = 0;
+
+  char *data = kernel_zalloc_pages(DISK_CACHE_BLOCKS * SECTOR_SIZE);
+  if (!data)
+  {
+    PANIC("Failed to allocate the disk cache\n");
+  }
+
+  for (int i = 0; i < DISK_CACHE_BLOCKS; i++)
+  {
+    disk_cache_blocks[i].data = data + i * SECTOR_SIZE;
+    disk_cache_lru_push_tail(&disk_cache_blocks[i]);
+  }
+}
+
+// Read one sector through the cache, a miss reads it from the disk into the least recently used block
+int disk_cache_read(struct disk_t *disk, unsigned int lba, void *buf)
+{
+  if (disk->sector_size > SECTOR_SIZE)
+  {
+    return -EINVARG;
+  }
+
+  struct disk_cache_block_t *block = disk_cache_find(disk, lba);
+  if (block)
+  {
+    disk_cache_counters.hits++;
+    disk_cache_lru_remove(block);
+    disk_cache_lru_push_head(block);
+    memcpy(buf, block->data, disk->sector_size);
+    return 0;
+  }
+
+  disk_cache_counters.misses++;
+  block = disk_cache_lru_tail;
+  if (!block)
+  {
+    // Every block is being filled by a task sleeping on the disk
+    return disk_read_block(disk, lba, 1, buf);
+  }
+
+  if (block->valid)
+  {
+    disk_cache_counters.evictions++;
+    disk_cache_hash_remove(block);
+    block->valid = false;
+  }
+
+  // The read may sleep, keep the block off the LRU list so no other miss picks it meanwhile
+  disk_cache_lru_remove(block);
+  int res = disk_read_block(disk, lba, 1, block->data);
+  if (res < 0)
+  {
+    // Leave the block at the tail for the next miss
+    disk_cache_lru_push_tail(block);
+    return res;
+  }
+
+  if (disk_cache_find(disk, lba))
+  {
+    // Another task cached the same sector while this one slept
+    disk_cache_lru_push_tail(block);
+    memcpy(buf, block->data, disk->sector_size);
+    return 0;
+  }
+
+  block->disk = disk;
+  block->lba = lba;
+  block->valid = true;
+
+  unsigned int bucket = disk_cache_hash(disk, lba);
+  block->hash_next = disk_cache_buckets[bucket];
+  disk_cache_buckets[bucket] = block;
+
+  disk_cache_lru_push_head(block);
+  memcpy(buf, block->data, disk->sector_size);
+  return 0;
+}
+
+void disk_cache_stats(struct disk_cache_stats_t *stats)
+{
+  *stats = disk_cache_counters;
+}
@@ -0,0 +1,38 @@
+#ifndef DISK_CACHE_H
+#define DISK_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <disk/disk.h>
+
+// A cached copy of one sector of a disk
+struct disk_cache_block_t
+{
+  struct disk_t *disk;
+  unsigned int lba;
+
+  // Whether the data holds the sector, blocks that failed to read or were never used don't
+  bool valid;
+
+  // The next block in the same hash bucket
+  struct disk_cache_block_t *hash_next;
+
+  // The neighbours in the LRU list, the head was used last
+  struct disk_cache_block_t *lru_prev;
+  struct disk_cache_block_t *lru_next;
+
+  char *data;
+};
+
+struct disk_cache_stats_t
+{
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+};
+
+void disk_cache_init();
+int disk_cache_read(struct disk_t *disk, unsigned int lba, void *buf);
+void disk_cache_stats(struct disk_cache_stats_t *stats);
+
+#endif
@@ -7,12 +7,24 @@ typedef unsigned int DISK_TYPE;
 
 // Represents a real physical hard disk
 #define DISK_TYPE_REAL 0
+// A virtio block device, as offered by QEMU
+#define DISK_TYPE_VIRTIO 1
+
+struct disk_t;
+
+typedef int (*DISK_READ_FUNCTION)(struct disk_t *disk, unsigned int lba, int total, void *buf);
 
 struct disk_t
 {
   DISK_TYPE type;
   int sector_size;
 
+  // Reads sectors into kernel memory for the driver of the disk
+  DISK_READ_FUNCTION read;
+
+  // The private data of the disk driver
+  void *driver_private;
+
   // The id of the disk
   int id;
 
@@ -23,6 +35,7 @@ struct disk_t
 };
 
 void disk_search_and_init();
+int disk_register(struct disk_t *disk);
 struct disk_t *disk_get(int index);
 int disk_read_block(struct disk_t *idisk, unsigned int lba, int total, void *buf);
 
@@ -1,8 +1,21 @@
 #include <stdbool.h>             // Include header file for boolean data type
 #include <disk/stream.h>         // Include header file for stream-related functionality
-#include <mm/heap/kernel_heap.h> // Include header file for kernel heap functionality
+#include <disk/cache.h>          // Include header file for the disk block cache
+#include <mm/slab/slab.h>         // Include header file for slab caches
 #include <common/system.h>       // Include configuration header file
 #include <kernel/kernel.h>
+#include <mm/memory.h>
+
+static struct kmem_cache_t *disk_stream_cache = 0; // Slab cache the disk streams are allocated from
+
+void disk_stream_init() // Function to create the disk stream cache
+{
+  disk_stream_cache = kmem_cache_create("disk_stream", sizeof(struct disk_stream_t), 0);
+  if (!disk_stream_cache)
+  {
+    PANIC("Failed to create the disk stream cache\n");
+  }
+}
 
 struct disk_stream_t *new_disk_stream(int disk_id) // Function to create a new disk stream
 {
@@ -12,7 +25,7 @@ struct disk_stream_t *new_disk_stream(int disk_id) // Function to create a new d
     return 0; // Return NULL to indicate failure
   }
 
-  struct disk_stream_t *stream = kernel_zalloc(sizeof(struct disk_stream_t)); // Allocate memory for a new disk stream structure
+  struct disk_stream_t *stream = kmem_cache_zalloc(disk_stream_cache);         // Allocate memory for a new disk stream structure
   stream->pos = 0;                                                            // Initialize the stream position to 0
   stream->disk = disk;                                                        // Set the disk for the stream
   return stream;                                                              // Return the newly created disk stream
@@ -24,41 +37,91 @@ int disk_stream_seek(struct disk_stream_t *stream, int pos) // Function to set t
   return 0;          // Return 0 to indicate success
 }
 
-int disk_stream_read(struct disk_stream_t *stream, void *out, int total) // Function to read data from the disk stream
+void disk_stream_set_cached(struct disk_stream_t *stream, bool cached) // Function to route the whole sectors of the stream through the cache
 {
-  int sector = stream->pos / SECTOR_SIZE;
-  int offset = stream->pos % SECTOR_SIZE;
-  int total_to_read = total;
-  bool overflow = (offset + total_to_read) >= SECTOR_SIZE;
-  char buf[SECTOR_SIZE];
+  stream->cached = cached;
+}
 
-  if (overflow)
+// Copy part of one sector through the block cache
+static int disk_stream_read_partial(struct disk_stream_t *stream, char *out, int offset, int total)
+{
+  char buf[SECTOR_SIZE];
+  int res = disk_cache_read(stream->disk, stream->pos / SECTOR_SIZE, buf);
+  if (res < 0)
   {
-    total_to_read -= (offset + total_to_read) - SECTOR_SIZE;
+    return res;
   }
 
-  int res = disk_read_block(stream->disk, sector, 1, buf);
-  if (res < 0)
+  memcpy(out, buf + offset, total);
+  stream->pos += total;
+  return 0;
+}
+
+// Read in up to three parts: the end of the first sector, the whole sectors in the middle
+// and the start of the last one. Unless the stream is cached, the whole sectors go straight
+// into the caller's buffer, many at a time, without passing through the cache
+int disk_stream_read(struct disk_stream_t *stream, void *out, int total) // Function to read data from the disk stream
+{
+  char *ptr = out;
+  int res = 0;
+
+  int offset = stream->pos % SECTOR_SIZE;
+  if (offset && total > 0)
   {
-    goto out;
+    int head = SECTOR_SIZE - offset;
+    if (head > total)
+    {
+      head = total;
+    }
+
+    res = disk_stream_read_partial(stream, ptr, offset, head);
+    if (res < 0)
+    {
+      goto out;
+    }
+
+    ptr += head;
+    total -= head;
   }
 
-  for (int i = 0; i < total_to_read; i++)
+  while (total >= SECTOR_SIZE)
   {
-    *(char *)out++ = buf[offset + i];
+    int sectors = 1;
+    if (stream->cached)
+    {
+      res = disk_cache_read(stream->disk, stream->pos / SECTOR_SIZE, ptr);
+    }
+    else
+    {
+      sectors = total / SECTOR_SIZE;
+      if (sectors > DISK_STREAM_MAX_SECTORS)
+      {
+        sectors = DISK_STREAM_MAX_SECTORS;
+      }
+
+      res = disk_read_block(stream->disk, stream->pos / SECTOR_SIZE, sectors, ptr);
+    }
+
+    if (res < 0)
+    {
+      goto out;
+    }
+
+    ptr += sectors * SECTOR_SIZE;
+    total -= sectors * SECTOR_SIZE;
+    stream->pos += sectors * SECTOR_SIZE;
   }
 
-  // Adjust the stream
-  stream->pos += total_to_read;
-  if (overflow)
+  if (total > 0)
   {
-    res = disk_stream_read(stream, out, total - total_to_read);
+    res = disk_stream_read_partial(stream, ptr, 0, total);
   }
+
 out:
   return res;
 }
 
 void disk_stream_close(struct disk_stream_t *stream) // Function to close the disk stream
 {
-  kernel_free(stream); // Free the memory allocated for the stream
+  kmem_cache_free(disk_stream_cache, stream); // Free the memory allocated for the stream
 }
@@ -1,16 +1,22 @@
 #ifndef DISK_STREAM_H
 #define DISK_STREAM_H
 
+#include <stdbool.h>
 #include <disk/disk.h>
 
 struct disk_stream_t
 {
   int pos;
   struct disk_t *disk;
+
+  // Whole sectors go through the block cache too, for metadata that is read again and again
+  bool cached;
 };
 
+void disk_stream_init();
 struct disk_stream_t *new_disk_stream(int disk_id);
 int disk_stream_seek(struct disk_stream_t *stream, int pos);
+void disk_stream_set_cached(struct disk_stream_t *stream, bool cached);
 int disk_stream_read(struct disk_stream_t *stream, void *out, int total);
 void disk_stream_close(struct disk_stream_t *stream);
 
@@ -0,0 +1,427 @@
+#include "drivers/ata/ata.h"
+#include "io/io.h"
+#include "idt/idt.h"
+#include "task/task.h"
+#include "kernel/kernel.h"
+#include "common/system.h"
+#include "drivers/pci/pci.h"
+#include "mm/heap/kernel_heap.h"
+#include "string/string.h"
+#include "timer/timer.h"
+#include "timer/wheel.h"
+
+static struct ata_channel_t ata_channels[ATA_TOTAL_CHANNELS] = {
+    {.io_base = ATA_PRIMARY_IO, .control_base = ATA_PRIMARY_CONTROL, .irq = ATA_PRIMARY_IRQ},
+    {.io_base = ATA_SECONDARY_IO, .control_base = ATA_SECONDARY_CONTROL, .irq = ATA_SECONDARY_IRQ}};
+
+// Aligned to their size so a table never crosses a 64KB boundary
+static struct ata_prd_t ata_prdts[ATA_TOTAL_CHANNELS][ATA_MAX_PRDS] __attribute__((aligned(sizeof(struct ata_prd_t) * ATA_MAX_PRDS)));
+
+static struct ata_channel_t *ata_channel(int drive)
+{
+  return &ata_channels[drive / 2];
+}
+
+// Spin until the drive clears BSY, a drive that never does fails the request instead of hanging the kernel
+static int ata_wait_not_busy(struct ata_channel_t *channel, uint8_t *status_out)
+{
+  uint64_t deadline = timer_now_ns() + ATA_TIMEOUT_NS;
+  uint8_t status = read_byte(channel->io_base + ATA_REG_STATUS);
+  while (status & ATA_STATUS_BSY)
+  {
+    if (timer_now_ns() > deadline)
+    {
+      return -EIO;
+    }
+
+    status = read_byte(channel->io_base + ATA_REG_STATUS);
+  }
+
+  *status_out = status;
+  return 0;
+}
+
+static void ata_read_data(struct ata_channel_t *channel, uint16_t *buf)
+{
+  for (int i = 0; i < ATA_SECTOR_WORDS; i++)
+  {
+    buf[i] = read_word(channel->io_base + ATA_REG_DATA);
+  }
+}
+
+// Clear the error and interrupt bits, they are cleared by writing them. The drive DMA capable bits
+// share the register and are plain read/write, so they are written back as they are
+static void ata_bm_clear_status(struct ata_channel_t *channel)
+{
+  uint8_t bm_status = read_byte(channel->bus_master + ATA_BM_STATUS);
+  write_byte(channel->bus_master + ATA_BM_STATUS, (bm_status & ATA_BM_STATUS_DRIVES_DMA) | ATA_BM_STATUS_ERROR | ATA_BM_STATUS_INTERRUPT);
+}
+
+// Describe the buffer of a request to the bus master, split at every 64KB boundary.
+// Kernel memory is identity mapped so its addresses are physical ones
+static void ata_dma_prepare(struct ata_channel_t *channel, struct ata_request_t *request)
+{
+  uint32_t address = (uint32_t)request->buf;
+  uint32_t left = request->total * ATA_SECTOR_WORDS * 2;
+  int i = 0;
+  while (left > 0)
+  {
+    uint32_t chunk = ATA_PRD_MAX_BYTES - (address & (ATA_PRD_MAX_BYTES - 1));
+    if (chunk > left)
+    {
+      chunk = left;
+    }
+
+    channel->prdt[i].address = address;
+    channel->prdt[i].size = chunk & 0xFFFF;
+    channel->prdt[i].flags = 0;
+    address += chunk;
+    left -= chunk;
+    i++;
+  }
+
+  channel->prdt[i - 1].flags = ATA_PRD_END;
+
+  write_dword(channel->bus_master + ATA_BM_PRDT, (uint32_t)channel->prdt);
+  write_byte(channel->bus_master + ATA_BM_COMMAND, ATA_BM_COMMAND_READ);
+  ata_bm_clear_status(channel);
+}
+
+// Stop the bus master once the drive is done, the drive status was already read
+static int ata_dma_finish(struct ata_channel_t *channel, uint8_t status)
+{
+  uint8_t bm_status = read_byte(channel->bus_master + ATA_BM_STATUS);
+  write_byte(channel->bus_master + ATA_BM_COMMAND, 0);
+  ata_bm_clear_status(channel);
+  if ((bm_status & ATA_BM_STATUS_ERROR) || (status & (ATA_STATUS_ERR | ATA_STATUS_DF)))
+  {
+    return -EIO;
+  }
+
+  return 0;
+}
+
+// Send the read command of a request, with the drive interrupt on or off.
+// An interrupt driven request arms the channel watchdog in case its IRQ never comes
+static int ata_issue(struct ata_channel_t *channel, struct ata_request_t *request, bool interrupts)
+{
+  uint8_t status = 0;
+  if (ata_wait_not_busy(channel, &status) < 0)
+  {
+    return -EIO;
+  }
+
+  write_byte(channel->control_base, interrupts ? 0 : ATA_CONTROL_NIEN);
+  if (request->dma)
+  {
+    ata_dma_prepare(channel, request);
+  }
+
+  unsigned int lba = request->lba;
+  write_byte(channel->io_base + ATA_REG_DRIVE, 0xE0 | ((request->drive % 2) << 4) | ((lba >> 24) & 0x0F));
+  write_byte(channel->io_base + ATA_REG_SECTOR_COUNT, (unsigned char)request->total);
+  write_byte(channel->io_base + ATA_REG_LBA_LOW, (unsigned char)(lba & 0xff));
+  write_byte(channel->io_base + ATA_REG_LBA_MID, (unsigned char)(lba >> 8));
+  write_byte(channel->io_base + ATA_REG_LBA_HIGH, (unsigned char)(lba >> 16));
+  write_byte(channel->io_base + ATA_REG_COMMAND, request->dma ? ATA_COMMAND_READ_DMA : ATA_COMMAND_READ_SECTORS);
+  if (request->dma)
+  {
+    write_byte(channel->bus_master + ATA_BM_COMMAND, ATA_BM_COMMAND_READ | ATA_BM_COMMAND_START);
+  }
+
+  if (interrupts)
+  {
+    timer_add_ns(&channel->watchdog, ATA_TIMEOUT_NS);
+  }
+
+  return 0;
+}
+
+// Finish the request on the drive, wake its task and start the next one.
+// Requests the drive won't take are failed in turn
+static void ata_complete(struct ata_channel_t *channel, int res)
+{
+  timer_cancel(&channel->watchdog);
+  while (channel->head)
+  {
+    struct ata_request_t *request = channel->head;
+    channel->head = request->next;
+    if (!channel->head)
+    {
+      channel->tail = 0;
+    }
+
+    request->res = res;
+    request->complete = true;
+    wait_queue_wake_all(&request->waiters);
+
+    if (!channel->head || ata_issue(channel, channel->head, true) == 0)
+    {
+      return;
+    }
+
+    res = -EIO;
+  }
+}
+
+// The IRQ of the request on the drive never came, stop the bus master and fail the request
+static void ata_watchdog(struct timer_t *timer)
+{
+  struct ata_channel_t *channel = timer->data;
+  if (!channel->head)
+  {
+    return;
+  }
+
+  if (channel->head->dma)
+  {
+    write_byte(channel->bus_master + ATA_BM_COMMAND, 0);
+  }
+
+  ata_complete(channel, -EIO);
+}
+
+// The drive raises its IRQ once every sector is ready to be read, or on an error.
+// With DMA it only raises it when the whole transfer is done
+static void ata_handle_interrupt(struct ata_channel_t *channel)
+{
+  // Reading the status register acknowledges the interrupt
+  uint8_t status = read_byte(channel->io_base + ATA_REG_STATUS);
+  struct ata_request_t *request = channel->head;
+  if (!request || (status & ATA_STATUS_BSY))
+  {
+    return;
+  }
+
+  if (request->dma)
+  {
+    ata_complete(channel, ata_dma_finish(channel, status));
+    return;
+  }
+
+  if (status & (ATA_STATUS_ERR | ATA_STATUS_DF))
+  {
+    ata_complete(channel, -EIO);
+    return;
+  }
+
+  if (!(status & ATA_STATUS_DRQ))
+  {
+    return;
+  }
+
+  ata_read_data(channel, request->buf + request->done * ATA_SECTOR_WORDS);
+  request->done++;
+  if (request->done == request->total)
+  {
+    ata_complete(channel, 0);
+  }
+}
+
+static void ata_primary_interrupt()
+{
+  ata_handle_interrupt(&ata_channels[0]);
+}
+
+static void ata_secondary_interrupt()
+{
+  ata_handle_interrupt(&ata_channels[1]);
+}
+
+// Busy wait for every sector, for reads made before there is a task that can sleep
+static int ata_read_polled(struct ata_channel_t *channel, struct ata_request_t *request)
+{
+  uint8_t status = 0;
+  if (ata_issue(channel, request, false) < 0)
+  {
+    return -EIO;
+  }
+
+  if (request->dma)
+  {
+    uint64_t deadline = timer_now_ns() + ATA_TIMEOUT_NS;
+    while (read_byte(channel->bus_master + ATA_BM_STATUS) & ATA_BM_STATUS_ACTIVE)
+    {
+      if (timer_now_ns() > deadline)
+      {
+        write_byte(channel->bus_master + ATA_BM_COMMAND, 0);
+        return -EIO;
+      }
+    }
+
+    if (ata_wait_not_busy(channel, &status) < 0)
+    {
+      write_byte(channel->bus_master + ATA_BM_COMMAND, 0);
+      return -EIO;
+    }
+
+    return ata_dma_finish(channel, status);
+  }
+
+  for (int b = 0; b < request->total; b++)
+  {
+    if (ata_wait_not_busy(channel, &status) < 0)
+    {
+      return -EIO;
+    }
+
+    uint64_t deadline = timer_now_ns() + ATA_TIMEOUT_NS;
+    while (!(status & (ATA_STATUS_DRQ | ATA_STATUS_ERR | ATA_STATUS_DF)))
+    {
+      if (timer_now_ns() > deadline)
+      {
+        return -EIO;
+      }
+
+      status = read_byte(channel->io_base + ATA_REG_STATUS);
+    }
+
+    if (status & (ATA_STATUS_ERR | ATA_STATUS_DF))
+    {
+      return -EIO;
+    }
+
+    ata_read_data(channel, request->buf + b * ATA_SECTOR_WORDS);
+  }
+
+  return 0;
+}
+
+// Read sectors from a drive. The calling task sleeps while the drive works and the IRQ
+// handler moves each sector into the buffer, so the buffer must be kernel memory
+int ata_read(int drive, unsigned int lba, int total, void *buf)
+{
+  if (drive < 0 || drive >= ATA_TOTAL_DRIVES || total <= 0 || total > ATA_MAX_SECTORS)
+  {
+    return -EINVARG;
+  }
+
+  struct ata_channel_t *channel = ata_channel(drive);
+  // The bus master moves words, odd buffers fall back to PIO
+  struct ata_request_t request = {.drive = drive, .lba = lba, .total = total, .buf = buf};
+  request.dma = channel->bus_master && !((uint32_t)buf & 1);
+  wait_queue_init(&request.waiters);
+
+  if (!task_can_block())
+  {
+    // Nothing is queued before the first task runs, the channel is ours
+    return ata_read_polled(channel, &request);
+  }
+
+  // Interrupts stay off in the kernel, the IRQ can't complete the request before we sleep on it
+  if (channel->tail)
+  {
+    channel->tail->next = &request;
+    channel->tail = &request;
+  }
+  else
+  {
+    channel->head = &request;
+    channel->tail = &request;
+    if (ata_issue(channel, &request, true) < 0)
+    {
+      ata_complete(channel, -EIO);
+    }
+  }
+
+  while (!request.complete)
+  {
+    wait_queue_sleep(&request.waiters);
+  }
+
+  return request.res;
+}
+
+// Find the PCI IDE controller and use its bus master registers for DMA, QEMU has a PIIX one
+static void ata_bus_master_init()
+{
+  struct pci_device_t *device = pci_find_class(PCI_CLASS_STORAGE, PCI_SUBCLASS_IDE, 0);
+  if (!device || !(device->prog_if & ATA_PROG_IF_BUS_MASTER))
+  {
+    return;
+  }
+
+  uint32_t bus_master = pci_bar(device, ATA_BM_BAR);
+  if (!bus_master)
+  {
+    return;
+  }
+
+  pci_enable(device, PCI_COMMAND_IO | PCI_COMMAND_BUS_MASTER);
+  for (int i = 0; i < ATA_TOTAL_CHANNELS; i++)
+  {
+    ata_channels[i].bus_master = bus_master + i * ATA_BM_CHANNEL_STRIDE;
+    ata_channels[i].prdt = ata_prdts[i];
+  }
+}
+
+void ata_init()
+{
+  ata_bus_master_init();
+  for (int i = 0; i < ATA_TOTAL_CHANNELS; i++)
+  {
+    struct ata_channel_t *channel = &ata_channels[i];
+    channel->head = 0;
+    channel->tail = 0;
+    timer_setup(&channel->watchdog, ata_watchdog, channel);
+
+    // Keep the drives quiet until a request wants their interrupt
+    write_byte(channel->control_base, ATA_CONTROL_NIEN);
+    idt_irq_enable(channel->irq);
+  }
+
+  idt_register_interrupt_callback(IDT_IRQ_BASE + ATA_PRIMARY_IRQ, ata_primary_interrupt);
+  idt_register_interrupt_callback(IDT_IRQ_BASE + ATA_SECONDARY_IRQ, ata_secondary_interrupt);
+}
+
+#if ATA_BOOT_BENCHMARK
+static void ata_benchmark_run(const char *name, void *buf, bool dma)
+{
+  struct ata_request_t request = {.drive = ATA_PRIMARY_MASTER, .lba = 0, .total = ATA_BENCHMARK_SECTORS, .buf = buf, .dma = dma};
+  uint64_t start = timer_now_ns();
+  for (int i = 0; i < ATA_BENCHMARK_ROUNDS; i++)
+  {
+    if (ata_read_polled(&ata_channels[0], &request) < 0)
+    {
+      print("ata: benchmark read failed\n");
+      return;
+    }
+  }
+
+  uint32_t us = (uint32_t)timer_divide(timer_now_ns() - start, 1000, 0);
+  if (!us)
+  {
+    us = 1;
+  }
+
+  // Kilobytes per second from the kilobytes read and the microseconds it took
+  uint64_t kb = ((uint64_t)ATA_BENCHMARK_SECTORS * ATA_BENCHMARK_ROUNDS * SECTOR_SIZE) >> 10;
+  char number[32];
+  print("ata: ");
+  print(name);
+  print(" ");
+  itoa(number, (uint32_t)timer_divide(kb * 1000000, us, 0), 10);
+  print(number);
+  print(" KB/s\n");
+}
+
+// Read the same sectors with PIO and with DMA and print the throughput of both, polled since it runs at boot
+void ata_benchmark()
+{
+  if (!ata_channels[0].bus_master)
+  {
+    print("ata: no bus master IDE controller\n");
+    return;
+  }
+
+  void *buf = kernel_malloc_pages(ATA_BENCHMARK_SECTORS * SECTOR_SIZE);
+  if (!buf)
+  {
+    return;
+  }
+
+  ata_benchmark_run("pio", buf, false);
+  ata_benchmark_run("dma", buf, true);
+  kernel_free(buf);
+}
+#endif
@@ -0,0 +1,135 @@
+#ifndef ATA_H
+#define ATA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <common/system.h>
+#include <task/waitqueue.h>
+#include <timer/wheel.h>
+
+// Register offsets from the I/O base of a channel
+#define ATA_REG_DATA 0x00
+#define ATA_REG_ERROR 0x01
+#define ATA_REG_SECTOR_COUNT 0x02
+#define ATA_REG_LBA_LOW 0x03
+#define ATA_REG_LBA_MID 0x04
+#define ATA_REG_LBA_HIGH 0x05
+#define ATA_REG_DRIVE 0x06
+#define ATA_REG_STATUS 0x07
+#define ATA_REG_COMMAND 0x07
+
+#define ATA_STATUS_ERR 0x01
+#define ATA_STATUS_DRQ 0x08
+#define ATA_STATUS_DF 0x20
+#define ATA_STATUS_BSY 0x80
+
+// Setting nIEN in the device control register stops the drive from raising its IRQ
+#define ATA_CONTROL_NIEN 0x02
+
+#define ATA_COMMAND_READ_SECTORS 0x20
+#define ATA_COMMAND_READ_DMA 0xC8
+
+// Bus master IDE registers from the base of a channel, the secondary channel is 8 ports up
+#define ATA_BM_COMMAND 0x00
+#define ATA_BM_STATUS 0x02
+#define ATA_BM_PRDT 0x04
+#define ATA_BM_CHANNEL_STRIDE 8
+
+#define ATA_BM_COMMAND_START 0x01
+// Transfer from the drive into memory
+#define ATA_BM_COMMAND_READ 0x08
+
+#define ATA_BM_STATUS_ACTIVE 0x01
+#define ATA_BM_STATUS_ERROR 0x02
+#define ATA_BM_STATUS_INTERRUPT 0x04
+// Set by the BIOS for the drives that can do DMA, bits 5 and 6
+#define ATA_BM_STATUS_DRIVES_DMA 0x60
+
+// The bar of the PCI IDE function holding the bus master registers
+#define ATA_BM_BAR 4
+// Set in the programming interface of IDE controllers that can bus master
+#define ATA_PROG_IF_BUS_MASTER 0x80
+
+// A physical region may not cross a 64KB boundary, a size of 0 means 64KB
+#define ATA_PRD_MAX_BYTES 0x10000
+#define ATA_PRD_END 0x8000
+#define ATA_MAX_PRDS 8
+
+#define ATA_PRIMARY_IO 0x1F0
+#define ATA_PRIMARY_CONTROL 0x3F6
+#define ATA_PRIMARY_IRQ 14
+#define ATA_SECONDARY_IO 0x170
+#define ATA_SECONDARY_CONTROL 0x376
+#define ATA_SECONDARY_IRQ 15
+
+#define ATA_TOTAL_CHANNELS 2
+
+// Drives are numbered master then slave on the primary channel, then on the secondary one
+#define ATA_PRIMARY_MASTER 0
+#define ATA_TOTAL_DRIVES (ATA_TOTAL_CHANNELS * 2)
+
+// The sector count register holds 8 bits, 0 means 256
+#define ATA_MAX_SECTORS 256
+#define ATA_SECTOR_WORDS 256
+
+// How long the drive gets to finish a command before the request fails with -EIO
+#define ATA_TIMEOUT_NS 5000000000ULL
+
+// Sectors and passes read by the boot time benchmark, the same sectors are read every pass
+#define ATA_BENCHMARK_SECTORS 256
+#define ATA_BENCHMARK_ROUNDS 16
+
+// One entry of the physical region descriptor table the bus master walks
+struct ata_prd_t
+{
+  uint32_t address;
+  uint16_t size;
+  uint16_t flags;
+} __attribute__((packed));
+
+// A read waiting for its channel, it lives on the stack of the task that sleeps on it
+struct ata_request_t
+{
+  int drive;
+  unsigned int lba;
+  int total;
+  uint16_t *buf;
+
+  // Whether the bus master moves the data instead of the processor
+  bool dma;
+
+  // Sectors transferred so far
+  int done;
+
+  int res;
+  bool complete;
+  struct wait_queue_t waiters;
+
+  struct ata_request_t *next;
+};
+
+struct ata_channel_t
+{
+  uint16_t io_base;
+  uint16_t control_base;
+  int irq;
+
+  // The bus master registers of the channel, 0 when there is no bus master controller
+  uint16_t bus_master;
+  struct ata_prd_t *prdt;
+
+  // Requests in the order they were issued, the head one is on the drive
+  struct ata_request_t *head;
+  struct ata_request_t *tail;
+
+  // Fails the head request when its IRQ never comes
+  struct timer_t watchdog;
+};
+
+void ata_init();
+int ata_read(int drive, unsigned int lba, int total, void *buf);
+#if ATA_BOOT_BENCHMARK
+void ata_benchmark();
+#endif
+
+#endif
@@ -63,7 +63,6 @@ uint8_t classic_keyboard_scancode_to_char(uint8_t scancode)
 
 void classic_keyboard_handle_interrupt()
 {
-  switch_to_kernel_page();
   uint8_t scancode = 0;
   scancode = read_byte(KEYBOARD_INPUT_PORT);
   read_byte(KEYBOARD_INPUT_PORT);
@@ -84,8 +83,6 @@ void classic_keyboard_handle_interrupt()
   {
     keyboard_push(c);
   }
-
-  switch_to_task_page();
 }
 
 struct keyboard_t *classic_init()
@@ -76,6 +76,10 @@ void keyboard_push(char c)
   int real_index = keyboard_get_tail_index(process);
   process->keyboard.buffer[real_index] = c;
   process->keyboard.tail++;
+
+  // Waking up on input is what interactive tasks do
+  wait_queue_wake_all(&process->keyboard_waiters);
+  task_boost(process->task);
 }
 
 char keyboard_pop()
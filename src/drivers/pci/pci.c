@@ -0,0 +1,133 @@
+#include "drivers/pci/pci.h"
+#include "io/io.h"
+#include "common/system.h"
+#include "mm/memory.h"
+
+// Every function found on the bus, filled in once at boot
+static struct pci_device_t pci_devices[PCI_MAX_DEVICES];
+static int pci_total_devices = 0;
+
+static uint32_t pci_config_address(uint8_t bus, uint8_t slot, uint8_t function, uint8_t offset)
+{
+  return 0x80000000 | ((uint32_t)bus << 16) | ((uint32_t)slot << 11) | ((uint32_t)function << 8) | (offset & 0xFC);
+}
+
+static uint32_t pci_read(uint8_t bus, uint8_t slot, uint8_t function, uint8_t offset)
+{
+  write_dword(PCI_CONFIG_ADDRESS, pci_config_address(bus, slot, function, offset));
+  return read_dword(PCI_CONFIG_DATA);
+}
+
+uint32_t pci_config_read(struct pci_device_t *device, uint8_t offset)
+{
+  return pci_read(device->bus, device->slot, device->function, offset);
+}
+
+void pci_config_write(struct pci_device_t *device, uint8_t offset, uint32_t value)
+{
+  write_dword(PCI_CONFIG_ADDRESS, pci_config_address(device->bus, device->slot, device->function, offset));
+  write_dword(PCI_CONFIG_DATA, value);
+}
+
+// The address in a base address register, without its type bits
+uint32_t pci_bar(struct pci_device_t *device, int index)
+{
+  uint32_t bar = pci_config_read(device, PCI_BAR0 + index * 4);
+  if (bar & PCI_BAR_IO)
+  {
+    return bar & PCI_BAR_IO_MASK;
+  }
+
+  return bar & PCI_BAR_MEMORY_MASK;
+}
+
+// Turn on decoding and bus mastering bits in the command register
+void pci_enable(struct pci_device_t *device, uint16_t command)
+{
+  uint32_t value = pci_config_read(device, PCI_COMMAND);
+  pci_config_write(device, PCI_COMMAND, (value & 0xFFFF) | command);
+}
+
+static void pci_add_function(uint8_t bus, uint8_t slot, uint8_t function)
+{
+  if (pci_total_devices >= PCI_MAX_DEVICES)
+  {
+    return;
+  }
+
+  uint32_t id = pci_read(bus, slot, function, PCI_VENDOR_ID);
+  uint32_t class_revision = pci_read(bus, slot, function, PCI_CLASS_REVISION);
+
+  struct pci_device_t *device = &pci_devices[pci_total_devices++];
+  device->bus = bus;
+  device->slot = slot;
+  device->function = function;
+  device->vendor_id = id & 0xFFFF;
+  device->device_id = id >> 16;
+  device->class_code = class_revision >> 24;
+  device->subclass = (class_revision >> 16) & 0xFF;
+  device->prog_if = (class_revision >> 8) & 0xFF;
+  device->interrupt_line = pci_read(bus, slot, function, PCI_INTERRUPT_LINE) & 0xFF;
+}
+
+// Scan every bus by brute force, functions past 0 are only probed on multi function devices
+void pci_init()
+{
+  memset(pci_devices, 0, sizeof(pci_devices));
+  pci_total_devices = 0;
+
+  for (int bus = 0; bus < PCI_TOTAL_BUSES; bus++)
+  {
+    for (int slot = 0; slot < PCI_TOTAL_SLOTS; slot++)
+    {
+      if ((pci_read(bus, slot, 0, PCI_VENDOR_ID) & 0xFFFF) == PCI_VENDOR_NONE)
+      {
+        continue;
+      }
+
+      pci_add_function(bus, slot, 0);
+      uint8_t header_type = (pci_read(bus, slot, 0, PCI_HEADER_TYPE) >> 16) & 0xFF;
+      if (!(header_type & PCI_HEADER_MULTI_FUNCTION))
+      {
+        continue;
+      }
+
+      for (int function = 1; function < PCI_TOTAL_FUNCTIONS; function++)
+      {
+        if ((pci_read(bus, slot, function, PCI_VENDOR_ID) & 0xFFFF) != PCI_VENDOR_NONE)
+        {
+          pci_add_function(bus, slot, function);
+        }
+      }
+    }
+  }
+}
+
+// The index-th device of a class, or 0 when there are not that many
+struct pci_device_t *pci_find_class(uint8_t class_code, uint8_t subclass, int index)
+{
+  for (int i = 0; i < pci_total_devices; i++)
+  {
+    struct pci_device_t *device = &pci_devices[i];
+    if (device->class_code == class_code && device->subclass == subclass && index-- == 0)
+    {
+      return device;
+    }
+  }
+
+  return 0;
+}
+
+struct pci_device_t *pci_find_device(uint16_t vendor_id, uint16_t device_id, int index)
+{
+  for (int i = 0; i < pci_total_devices; i++)
+  {
+    struct pci_device_t *device = &pci_devices[i];
+    if (device->vendor_id == vendor_id && device->device_id == device_id && index-- == 0)
+    {
+      return device;
+    }
+  }
+
+  return 0;
+}
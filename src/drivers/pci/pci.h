@@ -0,0 +1,62 @@
+#ifndef PCI_H
+#define PCI_H
+
+#include <stdint.h>
+
+// Configuration space is reached through an address and a data port
+#define PCI_CONFIG_ADDRESS 0xCF8
+#define PCI_CONFIG_DATA 0xCFC
+
+#define PCI_TOTAL_BUSES 256
+#define PCI_TOTAL_SLOTS 32
+#define PCI_TOTAL_FUNCTIONS 8
+
+// Offsets into the configuration space header
+#define PCI_VENDOR_ID 0x00
+#define PCI_COMMAND 0x04
+#define PCI_CLASS_REVISION 0x08
+#define PCI_HEADER_TYPE 0x0C
+#define PCI_BAR0 0x10
+#define PCI_INTERRUPT_LINE 0x3C
+
+#define PCI_VENDOR_NONE 0xFFFF
+#define PCI_HEADER_MULTI_FUNCTION 0x80
+
+#define PCI_COMMAND_IO 0x0001
+#define PCI_COMMAND_MEMORY 0x0002
+#define PCI_COMMAND_BUS_MASTER 0x0004
+
+// I/O space BARs have bit 0 set, the address is in the rest
+#define PCI_BAR_IO 0x01
+#define PCI_BAR_IO_MASK 0xFFFFFFFC
+#define PCI_BAR_MEMORY_MASK 0xFFFFFFF0
+
+#define PCI_CLASS_STORAGE 0x01
+#define PCI_SUBCLASS_IDE 0x01
+
+struct pci_device_t
+{
+  uint8_t bus;
+  uint8_t slot;
+  uint8_t function;
+
+  uint16_t vendor_id;
+  uint16_t device_id;
+
+  uint8_t class_code;
+  uint8_t subclass;
+  uint8_t prog_if;
+
+  // The PIC line the firmware routed the device interrupt to
+  uint8_t interrupt_line;
+};
+
+void pci_init();
+uint32_t pci_config_read(struct pci_device_t *device, uint8_t offset);
+void pci_config_write(struct pci_device_t *device, uint8_t offset, uint32_t value);
+uint32_t pci_bar(struct pci_device_t *device, int index);
+void pci_enable(struct pci_device_t *device, uint16_t command);
+struct pci_device_t *pci_find_class(uint8_t class_code, uint8_t subclass, int index);
+struct pci_device_t *pci_find_device(uint16_t vendor_id, uint16_t device_id, int index);
+
+#endif
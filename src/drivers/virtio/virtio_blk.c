@@ -0,0 +1,285 @@
+#include "drivers/virtio/virtio_blk.h"
+#include "drivers/pci/pci.h"
+#include "io/io.h"
+#include "idt/idt.h"
+#include "task/task.h"
+#include "kernel/kernel.h"
+#include "common/system.h"
+#include "mm/heap/kernel_heap.h"
+#include "mm/memory.h"
+
+static struct virtio_blk_t virtio_blk_devices[VIRTIO_BLK_MAX_DEVICES];
+static int virtio_blk_total_devices = 0;
+
+static uint32_t virtio_blk_align(uint32_t size)
+{
+  return (size + VIRTQ_ALIGN - 1) & ~(VIRTQ_ALIGN - 1);
+}
+
+static uint16_t virtio_blk_alloc_desc(struct virtio_blk_t *device)
+{
+  uint16_t id = device->free_head;
+  device->free_head = device->desc[id].next;
+  device->free_count--;
+  return id;
+}
+
+static void virtio_blk_free_chain(struct virtio_blk_t *device, uint16_t head)
+{
+  uint16_t id = head;
+  while (1)
+  {
+    uint16_t flags = device->desc[id].flags;
+    uint16_t next = device->desc[id].next;
+    device->desc[id].next = device->free_head;
+    device->free_head = id;
+    device->free_count++;
+    if (!(flags & VIRTQ_DESC_F_NEXT))
+    {
+      break;
+    }
+
+    id = next;
+  }
+}
+
+static void virtio_blk_set_desc(struct virtio_blk_t *device, uint16_t id, void *address, uint32_t length, uint16_t flags, uint16_t next)
+{
+  // Kernel memory is identity mapped so its addresses are physical ones
+  device->desc[id].address = (uint32_t)address;
+  device->desc[id].length = length;
+  device->desc[id].flags = flags;
+  device->desc[id].next = next;
+}
+
+// Chain the header, data and status descriptors of a request and make it available to the device
+static void virtio_blk_submit(struct virtio_blk_t *device, struct virtio_blk_request_t *request, int total, void *buf)
+{
+  uint16_t head = virtio_blk_alloc_desc(device);
+  uint16_t data = virtio_blk_alloc_desc(device);
+  uint16_t status = virtio_blk_alloc_desc(device);
+
+  virtio_blk_set_desc(device, head, &request->header, sizeof(request->header), VIRTQ_DESC_F_NEXT, data);
+  virtio_blk_set_desc(device, data, buf, total * SECTOR_SIZE, VIRTQ_DESC_F_WRITE | VIRTQ_DESC_F_NEXT, status);
+  virtio_blk_set_desc(device, status, (void *)&request->status, sizeof(request->status), VIRTQ_DESC_F_WRITE, 0);
+  device->requests[head] = request;
+
+  // The ring entry has to be in place before the index that publishes it
+  device->avail->ring[device->avail->idx % device->queue_size] = head;
+  device->avail->idx++;
+  write_word(device->io_base + VIRTIO_REG_QUEUE_NOTIFY, 0);
+}
+
+// Complete every request the device put in the used ring since we last looked
+static void virtio_blk_process_used(struct virtio_blk_t *device)
+{
+  bool freed = false;
+  while (device->last_used != device->used->idx)
+  {
+    uint16_t head = device->used->ring[device->last_used % device->queue_size].id;
+    device->last_used++;
+
+    struct virtio_blk_request_t *request = device->requests[head];
+    device->requests[head] = 0;
+    virtio_blk_free_chain(device, head);
+    freed = true;
+    if (!request)
+    {
+      continue;
+    }
+
+    request->res = request->status == VIRTIO_BLK_S_OK ? 0 : -EIO;
+    request->complete = true;
+    wait_queue_wake_all(&request->waiters);
+  }
+
+  if (freed)
+  {
+    wait_queue_wake_all(&device->free_waiters);
+  }
+}
+
+// Acknowledge the device and complete what it finished, for reads that can't sleep
+static void virtio_blk_poll(struct virtio_blk_t *device)
+{
+  read_byte(device->io_base + VIRTIO_REG_ISR_STATUS);
+  virtio_blk_process_used(device);
+}
+
+static void virtio_blk_interrupt()
+{
+  for (int i = 0; i < virtio_blk_total_devices; i++)
+  {
+    struct virtio_blk_t *device = &virtio_blk_devices[i];
+    // Reading the ISR status acknowledges the interrupt of the device
+    if (!device->polled && read_byte(device->io_base + VIRTIO_REG_ISR_STATUS))
+    {
+      virtio_blk_process_used(device);
+    }
+  }
+}
+
+// Read sectors into kernel memory. Any number of tasks can have a request in flight, each
+// sleeps until the interrupt completes its own. Before the first task runs, or when the
+// device has no usable interrupt, we poll instead
+static int virtio_blk_read(struct disk_t *disk, unsigned int lba, int total, void *buf)
+{
+  struct virtio_blk_t *device = disk->driver_private;
+  if (total <= 0 || (uint64_t)lba + total > device->capacity)
+  {
+    return -EINVARG;
+  }
+
+  struct virtio_blk_request_t request;
+  memset(&request, 0, sizeof(request));
+  request.header.type = VIRTIO_BLK_T_IN;
+  request.header.sector = lba;
+  request.status = 0xFF;
+  wait_queue_init(&request.waiters);
+
+  bool can_block = task_can_block() && !device->polled;
+  while (device->free_count < VIRTIO_BLK_REQUEST_DESCRIPTORS)
+  {
+    if (can_block)
+    {
+      wait_queue_sleep(&device->free_waiters);
+      continue;
+    }
+
+    virtio_blk_poll(device);
+  }
+
+  // Interrupts stay off in the kernel, the completion can't come before we sleep on it
+  virtio_blk_submit(device, &request, total, buf);
+  while (!request.complete)
+  {
+    if (can_block)
+    {
+      wait_queue_sleep(&request.waiters);
+      continue;
+    }
+
+    virtio_blk_poll(device);
+  }
+
+  return request.res;
+}
+
+// Set up queue 0 of the device in one page aligned block of memory
+static int virtio_blk_queue_init(struct virtio_blk_t *device)
+{
+  write_word(device->io_base + VIRTIO_REG_QUEUE_SELECT, 0);
+  uint16_t size = read_word(device->io_base + VIRTIO_REG_QUEUE_SIZE);
+  if (size < VIRTIO_BLK_REQUEST_DESCRIPTORS)
+  {
+    return -EIO;
+  }
+
+  uint32_t desc_size = sizeof(struct virtq_desc_t) * size;
+  uint32_t avail_size = sizeof(struct virtq_avail_t) + sizeof(uint16_t) * (size + 1);
+  uint32_t used_offset = virtio_blk_align(desc_size + avail_size);
+  uint32_t used_size = sizeof(struct virtq_used_t) + sizeof(struct virtq_used_elem_t) * size + sizeof(uint16_t);
+
+  char *queue = kernel_zalloc_pages(used_offset + virtio_blk_align(used_size));
+  device->requests = kernel_zalloc(sizeof(struct virtio_blk_request_t *) * size);
+  if (!queue || !device->requests)
+  {
+    kernel_free(queue);
+    kernel_free(device->requests);
+    return -ENOMEM;
+  }
+
+  device->queue_size = size;
+  device->desc = (struct virtq_desc_t *)queue;
+  device->avail = (struct virtq_avail_t *)(queue + desc_size);
+  device->used = (struct virtq_used_t *)(queue + used_offset);
+
+  for (uint16_t i = 0; i < size; i++)
+  {
+    device->desc[i].next = i + 1;
+  }
+
+  device->free_head = 0;
+  device->free_count = size;
+  device->last_used = 0;
+  wait_queue_init(&device->free_waiters);
+
+  write_dword(device->io_base + VIRTIO_REG_QUEUE_ADDRESS, (uint32_t)queue >> VIRTQ_ADDRESS_SHIFT);
+  return 0;
+}
+
+static int virtio_blk_init_device(struct virtio_blk_t *device, struct pci_device_t *pci)
+{
+  memset(device, 0, sizeof(*device));
+  device->pci = pci;
+  device->io_base = pci_bar(pci, 0);
+  pci_enable(pci, PCI_COMMAND_IO | PCI_COMMAND_BUS_MASTER);
+
+  // Reset the device and tell it we found it and can drive it
+  write_byte(device->io_base + VIRTIO_REG_DEVICE_STATUS, 0);
+  write_byte(device->io_base + VIRTIO_REG_DEVICE_STATUS, VIRTIO_STATUS_ACKNOWLEDGE);
+  write_byte(device->io_base + VIRTIO_REG_DEVICE_STATUS, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+
+  // None of the optional features are needed to read sectors
+  read_dword(device->io_base + VIRTIO_REG_DEVICE_FEATURES);
+  write_dword(device->io_base + VIRTIO_REG_GUEST_FEATURES, 0);
+
+  int res = virtio_blk_queue_init(device);
+  if (res < 0)
+  {
+    write_byte(device->io_base + VIRTIO_REG_DEVICE_STATUS, VIRTIO_STATUS_FAILED);
+    return res;
+  }
+
+  device->capacity = read_dword(device->io_base + VIRTIO_REG_BLK_CAPACITY) |
+                     ((uint64_t)read_dword(device->io_base + VIRTIO_REG_BLK_CAPACITY + 4) << 32);
+
+  // 0xFF means the firmware routed no line and the PICs only have 16. A line another driver
+  // already handles can't be shared, its callback is the only one that runs, so poll instead
+  int irq = pci->interrupt_line;
+  interrupt_callback_t owner = irq < IDT_TOTAL_IRQS ? idt_get_interrupt_callback(IDT_IRQ_BASE + irq) : 0;
+  if (irq >= IDT_TOTAL_IRQS || (owner && owner != virtio_blk_interrupt))
+  {
+    device->polled = true;
+  }
+  else
+  {
+    idt_register_interrupt_callback(IDT_IRQ_BASE + irq, virtio_blk_interrupt);
+    idt_irq_enable(irq);
+  }
+
+  write_byte(device->io_base + VIRTIO_REG_DEVICE_STATUS, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_DRIVER_OK);
+
+  device->disk.type = DISK_TYPE_VIRTIO;
+  device->disk.sector_size = SECTOR_SIZE;
+  device->disk.read = virtio_blk_read;
+  device->disk.driver_private = device;
+  return 0;
+}
+
+// Register every virtio block device on the PCI bus as a disk
+void virtio_blk_init()
+{
+  virtio_blk_total_devices = 0;
+  for (int i = 0; i < VIRTIO_BLK_MAX_DEVICES; i++)
+  {
+    struct pci_device_t *pci = pci_find_device(VIRTIO_VENDOR_ID, VIRTIO_BLK_DEVICE_ID, i);
+    if (!pci)
+    {
+      break;
+    }
+
+    struct virtio_blk_t *device = &virtio_blk_devices[virtio_blk_total_devices];
+    if (virtio_blk_init_device(device, pci) < 0)
+    {
+      continue;
+    }
+
+    // Count it first, its filesystem is resolved through it right away
+    virtio_blk_total_devices++;
+    if (disk_register(&device->disk) < 0)
+    {
+      break;
+    }
+  }
+}
@@ -0,0 +1,127 @@
+#ifndef VIRTIO_BLK_H
+#define VIRTIO_BLK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <disk/disk.h>
+#include <task/waitqueue.h>
+
+struct pci_device_t;
+
+// Transitional virtio block devices keep the legacy I/O port interface
+#define VIRTIO_VENDOR_ID 0x1AF4
+#define VIRTIO_BLK_DEVICE_ID 0x1001
+
+// Legacy virtio registers from the I/O BAR
+#define VIRTIO_REG_DEVICE_FEATURES 0x00
+#define VIRTIO_REG_GUEST_FEATURES 0x04
+#define VIRTIO_REG_QUEUE_ADDRESS 0x08
+#define VIRTIO_REG_QUEUE_SIZE 0x0C
+#define VIRTIO_REG_QUEUE_SELECT 0x0E
+#define VIRTIO_REG_QUEUE_NOTIFY 0x10
+#define VIRTIO_REG_DEVICE_STATUS 0x12
+#define VIRTIO_REG_ISR_STATUS 0x13
+// The block device configuration follows, starting with its capacity in sectors
+#define VIRTIO_REG_BLK_CAPACITY 0x14
+
+#define VIRTIO_STATUS_ACKNOWLEDGE 0x01
+#define VIRTIO_STATUS_DRIVER 0x02
+#define VIRTIO_STATUS_DRIVER_OK 0x04
+#define VIRTIO_STATUS_FAILED 0x80
+
+// The legacy interface takes the queue address as a page number and aligns the used ring to a page
+#define VIRTQ_ALIGN 4096
+#define VIRTQ_ADDRESS_SHIFT 12
+
+#define VIRTQ_DESC_F_NEXT 1
+#define VIRTQ_DESC_F_WRITE 2
+
+#define VIRTIO_BLK_T_IN 0
+#define VIRTIO_BLK_S_OK 0
+
+// A request is a header the device reads, the data and a status byte the device writes
+#define VIRTIO_BLK_REQUEST_DESCRIPTORS 3
+
+#define VIRTIO_BLK_MAX_DEVICES 2
+
+struct virtq_desc_t
+{
+  uint64_t address;
+  uint32_t length;
+  uint16_t flags;
+  uint16_t next;
+} __attribute__((packed));
+
+struct virtq_avail_t
+{
+  uint16_t flags;
+  uint16_t idx;
+  uint16_t ring[];
+} __attribute__((packed));
+
+struct virtq_used_elem_t
+{
+  uint32_t id;
+  uint32_t length;
+} __attribute__((packed));
+
+struct virtq_used_t
+{
+  uint16_t flags;
+  uint16_t idx;
+  struct virtq_used_elem_t ring[];
+} __attribute__((packed));
+
+struct virtio_blk_request_header_t
+{
+  uint32_t type;
+  uint32_t reserved;
+  uint64_t sector;
+} __attribute__((packed));
+
+// A read in flight, it lives on the stack of the task that sleeps on it
+struct virtio_blk_request_t
+{
+  struct virtio_blk_request_header_t header;
+  volatile uint8_t status;
+
+  int res;
+  bool complete;
+  struct wait_queue_t waiters;
+};
+
+struct virtio_blk_t
+{
+  struct disk_t disk;
+  struct pci_device_t *pci;
+  uint16_t io_base;
+
+  // Sectors on the device
+  uint64_t capacity;
+
+  // The single request queue, laid out the way the legacy interface wants it
+  uint16_t queue_size;
+  volatile struct virtq_desc_t *desc;
+  volatile struct virtq_avail_t *avail;
+  volatile struct virtq_used_t *used;
+
+  // Unused descriptors are chained through their next fields
+  uint16_t free_head;
+  uint16_t free_count;
+
+  // The used ring entries we already completed
+  uint16_t last_used;
+
+  // The request of every descriptor chain in flight, by its head descriptor
+  struct virtio_blk_request_t **requests;
+
+  // Tasks waiting for descriptors to send their request
+  struct wait_queue_t free_waiters;
+
+  // The device has no interrupt we can use, every read polls the used ring
+  bool polled;
+};
+
+void virtio_blk_init();
+
+#endif
@@ -4,6 +4,7 @@
 #include "disk/disk.h"
 #include "disk/stream.h"
 #include "mm/heap/kernel_heap.h"
+#include "mm/slab/slab.h"
 #include "mm/memory.h"
 
 #include "kernel/kernel.h"
@@ -150,9 +151,20 @@ struct filesystem_t fat16_fs =
         .stat = fat16_stat,
         .close = fat16_close};
 
+// Slab caches for the small objects created on every open
+static struct kmem_cache_t *fat_item_cache = 0;
+static struct kmem_cache_t *fat_file_descriptor_cache = 0;
+
 // Initialize FAT16 filesystem
 struct filesystem_t *fat16_init()
 {
+  fat_item_cache = kmem_cache_create("fat_item", sizeof(struct fat_item_t), 0);
+  fat_file_descriptor_cache = kmem_cache_create("fat_file_descriptor", sizeof(struct fat_file_descriptor_t), 0);
+  if (!fat_item_cache || !fat_file_descriptor_cache)
+  {
+    PANIC("Failed to create the FAT16 caches\n");
+  }
+
   strcpy(fat16_fs.name, "FAT16"); // Set the filesystem name
   return &fat16_fs;               // Return the filesystem struct
 }
@@ -166,6 +178,10 @@ static void fat16_init_private(struct disk_t *disk, struct fat_private_t *privat
       ->fat_read_stream = new_disk_stream(disk->id);
   private
       ->directory_stream = new_disk_stream(disk->id);
+
+  // The FAT and the directories are read over and over while resolving paths, file data is not
+  disk_stream_set_cached(private->fat_read_stream, true);
+  disk_stream_set_cached(private->directory_stream, true);
 }
 
 int fat16_sector_to_absolute(struct disk_t *disk, int sector)
@@ -535,7 +551,7 @@ void fat16_fat_item_free(struct fat_item_t *item)
     kernel_free(item->item);
   }
 
-  kernel_free(item);
+  kmem_cache_free(fat_item_cache, item);
 }
 
 struct fat_directory_t *fat16_load_fat_directory(struct disk_t *disk, struct fat_directory_item_t *item)
@@ -568,7 +584,7 @@ struct fat_directory_t *fat16_load_fat_directory(struct disk_t *disk, struct fat
     goto out;
   }
 
-  res = fat16_read_internal(disk, cluster, 0x00, directory_size, directory->item);
+  res = fat16_read_internal_from_stream(disk, fat_private->directory_stream, cluster, 0x00, directory_size, directory->item);
   if (res != ALL_OK)
   {
     goto out;
@@ -583,7 +599,7 @@ out:
 }
 struct fat_item_t *fat16_new_fat_item_for_directory_item(struct disk_t *disk, struct fat_directory_item_t *item)
 {
-  struct fat_item_t *f_item = kernel_zalloc(sizeof(struct fat_item_t));
+  struct fat_item_t *f_item = kmem_cache_zalloc(fat_item_cache);
   if (!f_item)
   {
     return 0;
@@ -656,7 +672,7 @@ void *fat16_open(struct disk_t *disk, struct path_part_t *path, FILE_MODE mode)
     goto err_out;
   }
 
-  descriptor = kernel_zalloc(sizeof(struct fat_file_descriptor_t));
+  descriptor = kmem_cache_zalloc(fat_file_descriptor_cache);
   if (!descriptor)
   {
     err_code = -ENOMEM;
@@ -675,7 +691,7 @@ void *fat16_open(struct disk_t *disk, struct path_part_t *path, FILE_MODE mode)
 
 err_out:
   if (descriptor)
-    kernel_free(descriptor);
+    kmem_cache_free(fat_file_descriptor_cache, descriptor);
 
   return ERROR(err_code);
 }
@@ -683,7 +699,7 @@ err_out:
 static void fat16_free_file_descriptor(struct fat_file_descriptor_t *desc)
 {
   fat16_fat_item_free(desc->item);
-  kernel_free(desc);
+  kmem_cache_free(fat_file_descriptor_cache, desc);
 }
 
 int fat16_close(void *private)
@@ -1,15 +1,20 @@
 #include "file.h"                    // Include the "file.h" header file
 #include "common/system.h"                  // Include the "config.h" header file
 #include "mm/memory.h"           // Include the "memory/memory.h" header file
-#include "mm/heap/kernel_heap.h" // Include the "memory/heap/kernel_heap.h" header file
+#include "mm/slab/slab.h"         // Include the "mm/slab/slab.h" header file
 #include "string/string.h"           // Include the "string/string.h" header file
 #include "disk/disk.h"               // Include the "disk/disk.h" header file
 #include "fat/fat16.h"               // Include the "fat/fat16.h" header file
                   // Include the "status.h" header file
 #include "kernel/kernel.h"                  // Include the "kernel.h" header file
+#include "task/mutex.h"                     // Include the "task/mutex.h" header file
 
 struct filesystem_t *filesystems[MAX_FILESYSTEMS];                // Array of pointers to filesystems
 struct file_descriptor_t *file_descriptors[MAX_FILE_DESCRIPTORS]; // Array of pointers to file descriptors
+static struct kmem_cache_t *file_descriptor_cache = 0;            // Slab cache the file descriptors are allocated from
+
+// Disk reads sleep, so tasks take turns through the filesystems, their shared streams and the disk cache
+static struct mutex_t fs_lock;
 
 // Function to get a pointer to a free filesystem slot
 static struct filesystem_t **fs_get_free_filesystem()
@@ -59,6 +64,14 @@ void fs_load()
 void fs_init()
 {
   memset(file_descriptors, 0x00, sizeof(file_descriptors));
+  mutex_init(&fs_lock);
+  file_descriptor_cache = kmem_cache_create("file_descriptor", sizeof(struct file_descriptor_t), 0);
+  if (!file_descriptor_cache)
+  {
+    PANIC("Failed to create the file descriptor cache\n");
+  }
+
+  parser_init();
   fs_load();
 }
 
@@ -67,7 +80,7 @@ void fs_init()
 static void file_free_descriptor(struct file_descriptor_t *desc)
 {
   file_descriptors[desc->index - 1] = 0x00;
-  kernel_free(desc);
+  kmem_cache_free(file_descriptor_cache, desc);
 }
 
 // Function to create a new file descriptor
@@ -78,7 +91,7 @@ static int file_new_descriptor(struct file_descriptor_t **desc_out)
   {
     if (file_descriptors[i] == 0)
     {
-      struct file_descriptor_t *desc = kernel_zalloc(sizeof(struct file_descriptor_t));
+      struct file_descriptor_t *desc = kmem_cache_zalloc(file_descriptor_cache);
       // Descriptors start at 1
       desc->index = i + 1;
       file_descriptors[i] = desc;
@@ -143,6 +156,7 @@ FILE_MODE file_get_mode_by_string(const char *str)
 int fopen(const char *filename, const char *mode_str)
 {
   int res = 0;
+  mutex_lock(&fs_lock);
   struct path_root_t *root_path = parser_parse(filename, NULL);
   if (!root_path)
   {
@@ -197,6 +211,7 @@ int fopen(const char *filename, const char *mode_str)
   res = desc->index;
 
 out:
+  mutex_unlock(&fs_lock);
   // fopen shouldnt return negative values
   if (res < 0)
     res = 0;
@@ -208,6 +223,7 @@ out:
 int fstat(int fd, struct file_stat_t *stat)
 {
   int res = 0;
+  mutex_lock(&fs_lock);
   struct file_descriptor_t *desc = file_get_descriptor(fd);
   if (!desc)
   {
@@ -217,6 +233,7 @@ int fstat(int fd, struct file_stat_t *stat)
 
   res = desc->filesystem->stat(desc->disk, desc->private, stat);
 out:
+  mutex_unlock(&fs_lock);
   return res;
 }
 
@@ -224,6 +241,7 @@ out:
 int fclose(int fd)
 {
   int res = 0;
+  mutex_lock(&fs_lock);
   struct file_descriptor_t *desc = file_get_descriptor(fd);
   if (!desc)
   {
@@ -237,6 +255,7 @@ int fclose(int fd)
     file_free_descriptor(desc);
   }
 out:
+  mutex_unlock(&fs_lock);
   return res;
 }
 
@@ -244,6 +263,7 @@ out:
 int fseek(int fd, int offset, FILE_SEEK_MODE whence)
 {
   int res = 0;
+  mutex_lock(&fs_lock);
   struct file_descriptor_t *desc = file_get_descriptor(fd);
   if (!desc)
   {
@@ -253,6 +273,7 @@ int fseek(int fd, int offset, FILE_SEEK_MODE whence)
 
   res = desc->filesystem->seek(desc->private, offset, whence);
 out:
+  mutex_unlock(&fs_lock);
   return res;
 }
 
@@ -260,6 +281,7 @@ out:
 int fread(void *ptr, uint32_t size, uint32_t nmemb, int fd)
 {
   int res = 0;
+  mutex_lock(&fs_lock);
   if (size == 0 || nmemb == 0 || fd < 1)
   {
     res = -EINVARG;
@@ -275,5 +297,6 @@ int fread(void *ptr, uint32_t size, uint32_t nmemb, int fd)
 
   res = desc->filesystem->read(desc->disk, desc->private, size, nmemb, (char *)ptr);
 out:
+  mutex_unlock(&fs_lock);
   return res;
 }
@@ -1,11 +1,27 @@
 #include "parser.h"                  // Include header file for parser functionality
 #include "kernel/kernel.h"                  // Include header file for kernel functionality
 #include "string/string.h"           // Include header file for string manipulation
-#include "mm/heap/kernel_heap.h" // Include header file for kernel heap functionality
+#include "mm/slab/slab.h"         // Include header file for slab caches
 #include "mm/memory.h"           // Include header file for memory management
                   // Include header file for status codes
 #include "common/system.h"                  // Include header file for configuration
 
+// Slab caches for the path structures and the path part strings
+static struct kmem_cache_t *path_root_cache = 0;
+static struct kmem_cache_t *path_part_cache = 0;
+static struct kmem_cache_t *path_string_cache = 0;
+
+void parser_init()
+{
+  path_root_cache = kmem_cache_create("path_root", sizeof(struct path_root_t), 0);
+  path_part_cache = kmem_cache_create("path_part", sizeof(struct path_part_t), 0);
+  path_string_cache = kmem_cache_create("path_string", MAX_PATH, 0);
+  if (!path_root_cache || !path_part_cache || !path_string_cache)
+  {
+    PANIC("Failed to create the path caches\n");
+  }
+}
+
 static int parser_path_valid_format(const char *filename)
 {
   int len = strnlen(filename, MAX_PATH); // Get the length of the filename up to MAX_PATH characters
@@ -29,7 +45,7 @@ static int parser_get_drive_by_path(const char **path)
 
 static struct path_root_t *parser_create_root(int drive_number)
 {
-  struct path_root_t *path_r = kernel_zalloc(sizeof(struct path_root_t));
+  struct path_root_t *path_r = kmem_cache_zalloc(path_root_cache);
   // Allocate memory for the path_root structure
   path_r->drive_no = drive_number; // Set the drive number in the path_root structure
   path_r->first = 0;               // Set the first path_part pointer to NULL
@@ -38,7 +54,7 @@ static struct path_root_t *parser_create_root(int drive_number)
 
 static const char *parser_get_path_part(const char **path)
 {
-  char *result_path_part = kernel_zalloc(MAX_PATH);
+  char *result_path_part = kmem_cache_zalloc(path_string_cache);
   // Allocate memory for the path part
   int i = 0;
   while (**path != '/' && **path != 0x00)
@@ -56,7 +72,7 @@ static const char *parser_get_path_part(const char **path)
 
   if (i == 0)
   {
-    kernel_free(result_path_part);
+    kmem_cache_free(path_string_cache, result_path_part);
     result_path_part = 0;
   }
 
@@ -72,7 +88,7 @@ struct path_part_t *parser_parse_path_part(struct path_part_t *last_part, const
     return 0; // If the path part is empty, return NULL
   }
 
-  struct path_part_t *part = kernel_zalloc(sizeof(struct path_part_t));
+  struct path_part_t *part = kmem_cache_zalloc(path_part_cache);
   // Allocate memory for the path_part structure
   part->part = path_part_str; // Set the path part in the path_part structure
   part->next = 0x00;          // Set the next path_part pointer to NULL
@@ -91,12 +107,12 @@ void parser_free(struct path_root_t *root)
   while (part)
   {
     struct path_part_t *next_part = part->next; // Get the next path_part in the path_root
-    kernel_free((void *)part->part);          // Free the memory allocated for the path part
-    kernel_free(part);                        // Free the memory allocated for the path_part structure
+    kmem_cache_free(path_string_cache, (void *)part->part); // Free the memory allocated for the path part
+    kmem_cache_free(path_part_cache, part);                  // Free the memory allocated for the path_part structure
     part = next_part;                         // Move to the next path_part
   }
 
-  kernel_free(root); // Free the memory allocated for the path_root structure
+  kmem_cache_free(path_root_cache, root); // Free the memory allocated for the path_root structure
 }
 
 struct path_root_t *parser_parse(const char *path, const char *current_directory_path)
@@ -13,6 +13,7 @@ struct path_part_t
   struct path_part_t *next;
 };
 
+void parser_init();
 struct path_root_t *parser_parse(const char *path, const char *current_directory_path);
 void parser_free(struct path_root_t *root);
 
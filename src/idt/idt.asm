@@ -2,13 +2,19 @@ section .asm ; Defines the section of the assembly code
 
 extern no_interrupt_handler
 extern isr80h_handler
+extern isr80h_sysenter_handler
 extern interrupt_handler
+extern kernel_tss
 
 global load_idt
 global no_interrupt
 global enable_interrupts
 global disable_interrupts
+global wait_for_interrupt
 global isr80h_wrapper
+global isr80h_sysenter_wrapper
+global cpu_has_sysenter
+global write_msr
 global interrupt_pointer_table
 
 enable_interrupts:
@@ -19,6 +25,12 @@ disable_interrupts:
     cli ; Disable interrupts by clearing the interrupt flag (IF) in the EFLAGS register
     ret ; Return from the function, popping the return address from the stack and transferring control back
 
+wait_for_interrupt:
+    sti ; Enable interrupts, the sti shadow keeps them off until hlt has started
+    hlt ; Halt the processor until the next interrupt has been handled
+    cli ; Disable interrupts again before returning to the caller
+    ret ; Return from the function, popping the return address from the stack and transferring control back
+
 load_idt: ; Start of the "load_idt" function
     push ebp ; Preserve the value of the base pointer (ebp) by pushing it onto the stack
     mov ebp, esp ; Set up a new base pointer (ebp) by copying the current stack pointer (esp)
@@ -89,6 +101,82 @@ isr80h_wrapper:
     mov eax, [tmp_res]
     iretd
 
+isr80h_sysenter_wrapper:
+    ; SYSENTER only loads the kernel CS, SS, ESP and EIP from the MSRs and clears IF.
+    ; The user stub passes its return address in edx and its stack pointer in ecx,
+    ; with the ecx and edx arguments stored at [ecx] and [ecx+4]. Those are user
+    ; memory, isr80h_sysenter_handler copies them in through the task's page tables
+
+    ; Move to the kernel stack of the current task, esp0 is the second field of the TSS
+    mov esp, [kernel_tss+4]
+
+    ; Build the frame isr80h_wrapper gets from the processor
+    push dword 0x23 ; ss
+    push ecx ; sp
+    pushfd
+    or dword [esp], 0x200 ; flags, the task runs with interrupts enabled
+    push dword 0x1B ; cs
+    push edx ; ip
+
+    ; Push the general purpose registers in pushad order
+    push eax
+    push dword 0 ; ecx, filled in by isr80h_sysenter_handler
+    push dword 0 ; edx, filled in by isr80h_sysenter_handler
+    push ebx
+    push dword 0 ; esp, ignored like the one pushad stores
+    push ebp
+    push esi
+    push edi
+
+    ; Push the stack pointer so that we are pointing to the interrupt frame
+    push esp
+
+    ; EAX holds our command lets push it to the stack for isr80h_sysenter_handler
+    push eax
+    call isr80h_sysenter_handler
+    add esp, 8
+
+    ; Restore the registers the user stub expects to be preserved, eax holds the result
+    pop edi
+    pop esi
+    pop ebp
+    add esp, 4
+    pop ebx
+    add esp, 12 ; edx, ecx and eax
+
+    ; SYSEXIT returns to edx with the stack in ecx
+    pop edx ; ip
+    add esp, 8 ; cs and flags
+    pop ecx ; sp
+    add esp, 4 ; ss
+
+    ; The sti shadow holds interrupts off until SYSEXIT has left the kernel stack
+    sti
+    sysexit
+
+cpu_has_sysenter:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, 1
+    cpuid
+    mov eax, edx
+    shr eax, 11
+    and eax, 1
+    pop ebx
+    pop ebp
+    ret
+
+write_msr:
+    push ebp
+    mov ebp, esp
+    mov ecx, [ebp+8]
+    mov eax, [ebp+12]
+    mov edx, [ebp+16]
+    wrmsr
+    pop ebp
+    ret
+
 section .data
 ; Inside here is stored the return result from isr80h_handler
 tmp_res: dd 0
@@ -5,7 +5,11 @@
 #include "mm/memory.h"
 #include "task/task.h"
 #include "task/process.h"
-
+#include "isr80h/isr80h.h"
+#include "isr80h/stats.h"
+#include "timer/timer.h"
+#include "timer/wheel.h"
+#include <stdbool.h>
 
 struct idt_entry_t idt_descriptors[TOTAL_INTERRUPTS];
 struct idt_ptr_t idt_ptr_t;
@@ -16,10 +20,17 @@ static interrupt_callback_t interrupt_callbacks[TOTAL_INTERRUPTS];
 
 static isr80h_cmd_t isr80h_commands[MAX_ISR80H_COMMANDS];
 
+// Set once the SYSENTER MSRs point at the kernel entry
+static bool sysenter_enabled = false;
+
 extern void load_idt(struct idt_ptr_t *ptr);
 
 extern void no_interrupt();
 extern void isr80h_wrapper();
+extern void isr80h_sysenter_wrapper();
+
+extern int cpu_has_sysenter();
+extern void write_msr(uint32_t msr, uint32_t low, uint32_t high);
 
 void no_interrupt_handler()
 {
@@ -28,14 +39,27 @@ void no_interrupt_handler()
 
 void interrupt_handler(int interrupt, struct interrupt_frame_t *frame)
 {
-  switch_to_kernel_page();
+  // The kernel is mapped in every task directory so we stay on the task's address space
+  kernel_registers();
   if (interrupt_callbacks[interrupt] != 0)
   {
-    task_current_save_state(frame);
+    // The interrupted task may have just exited
+    if (task_current())
+    {
+      task_current_save_state(frame);
+    }
+
     interrupt_callbacks[interrupt](frame);
   }
 
-  switch_to_task_page();
+  user_registers();
+
+  // IRQs from the slave PIC are acknowledged on both controllers
+  if (interrupt >= IDT_IRQ_SLAVE_BASE && interrupt < IDT_IRQ_BASE + IDT_TOTAL_IRQS)
+  {
+    write_byte(0xA0, 0x20);
+  }
+
   write_byte(0x20, 0x20);
 }
 
@@ -51,6 +75,11 @@ void set_idt(int interrupt_no, void *address)
 
 void idt_handle_exception()
 {
+  if (!task_current() || task_is_idle(task_current()))
+  {
+    PANIC("Exception while no task was running\n");
+  }
+
   process_terminate(task_current()->process);
   task_next();
 }
@@ -59,8 +88,36 @@ void idt_clock()
 {
   write_byte(0x20, 0x20);
 
-  // Switch to the next task
-  task_next();
+  timer_tick();
+
+  // Fire the timers that are due, only the current slot of each level is touched
+  timer_wheel_run(timer_ticks());
+
+  // Let the scheduler account the tick, it switches tasks when the slice is used up
+  task_tick();
+}
+
+// Mask the clock interrupt at the PIC, for when no task needs to be preempted
+void idt_clock_stop()
+{
+  write_byte(0x21, read_byte(0x21) | 0x01);
+}
+
+void idt_clock_start()
+{
+  write_byte(0x21, read_byte(0x21) & ~0x01);
+}
+
+// Unmask a hardware IRQ at the PIC, the slave ones also need the cascade on the master
+void idt_irq_enable(int irq)
+{
+  if (irq >= 8)
+  {
+    write_byte(0xA1, read_byte(0xA1) & ~(1 << (irq - 8)));
+    irq = 2;
+  }
+
+  write_byte(0x21, read_byte(0x21) & ~(1 << irq));
 }
 
 void init_idt()
@@ -77,6 +134,10 @@ void init_idt()
 
   set_idt(0x80, isr80h_wrapper);
 
+#if ISR80H_SYSCALL_STATS
+  isr80h_stats_init();
+#endif
+
   for (int i = 0; i < 0x20; i++)
   {
     idt_register_interrupt_callback(i, idt_handle_exception);
@@ -88,6 +149,28 @@ void init_idt()
   load_idt(&idt_ptr_t);
 }
 
+// Let user programs enter the kernel with SYSENTER. The entry switches to the task's
+// kernel stack from the TSS right away, the stack given here is only used until then
+void init_sysenter(uint32_t kernel_stack)
+{
+  if (!cpu_has_sysenter())
+  {
+    return;
+  }
+
+  // SYSEXIT derives the user selectors from this one, the GDT keeps user code and data right after the kernel segments
+  write_msr(IA32_SYSENTER_CS, KERNEL_CODE_SELECTOR, 0);
+  write_msr(IA32_SYSENTER_ESP, kernel_stack, 0);
+  write_msr(IA32_SYSENTER_EIP, (uint32_t)isr80h_sysenter_wrapper, 0);
+  sysenter_enabled = true;
+}
+
+// Whether user programs can enter through SYSENTER, they have to use int 0x80 otherwise
+bool idt_sysenter_enabled()
+{
+  return sysenter_enabled;
+}
+
 int idt_register_interrupt_callback(int interrupt, interrupt_callback_t interrupt_callback)
 {
   if (interrupt < 0 || interrupt >= TOTAL_INTERRUPTS)
@@ -99,6 +182,17 @@ int idt_register_interrupt_callback(int interrupt, interrupt_callback_t interrup
   return 0;
 }
 
+// The callback registered for an interrupt, 0 when there is none
+interrupt_callback_t idt_get_interrupt_callback(int interrupt)
+{
+  if (interrupt < 0 || interrupt >= TOTAL_INTERRUPTS)
+  {
+    return 0;
+  }
+
+  return interrupt_callbacks[interrupt];
+}
+
 void isr80h_register_command(int id, isr80h_cmd_t command)
 {
   if (id < 0 || id >= MAX_ISR80H_COMMANDS)
@@ -114,6 +208,31 @@ void isr80h_register_command(int id, isr80h_cmd_t command)
   isr80h_commands[id] = command;
 }
 
+// Fetch a syscall argument, from the saved registers or from the user stack in compatibility mode
+void *isr80h_get_argument(struct interrupt_frame_t *frame, int index)
+{
+  if (!task_current()->syscall_register_args)
+  {
+    return task_get_stack_item(task_current(), index);
+  }
+
+  switch (index)
+  {
+  case 0:
+    return (void *)frame->ebx;
+  case 1:
+    return (void *)frame->ecx;
+  case 2:
+    return (void *)frame->edx;
+  case 3:
+    return (void *)frame->esi;
+  case 4:
+    return (void *)frame->edi;
+  }
+
+  return 0;
+}
+
 void *isr80h_handle_command(int command, struct interrupt_frame_t *frame)
 {
   void *result = 0;
@@ -130,16 +249,63 @@ void *isr80h_handle_command(int command, struct interrupt_frame_t *frame)
     return 0;
   }
 
+#if ISR80H_SYSCALL_STATS
+  // Count the call up front, commands that end the task never come back to be timed
+  struct process_t *process = task_current()->process;
+  isr80h_stats_count(command, process);
+  uint64_t start = read_tsc();
+#endif
+
   result = handler(frame);
+
+#if ISR80H_SYSCALL_STATS
+  isr80h_stats_time(command, process, read_tsc() - start);
+#endif
+
   return result;
 }
 
+// Dispatch a command whose arguments are in the frame registers, no matter how the current syscall passed its own
+void *isr80h_handle_register_command(int command, struct interrupt_frame_t *frame)
+{
+  struct task_t *task = task_current();
+  bool register_args = task->syscall_register_args;
+  task->syscall_register_args = true;
+  void *res = isr80h_handle_command(command, frame);
+  task->syscall_register_args = register_args;
+  return res;
+}
+
 void *isr80h_handler(int command, struct interrupt_frame_t *frame)
 {
   void *res = 0;
-  switch_to_kernel_page();
+  kernel_registers();
+  task_current_save_state(frame);
+  // Kept with the task, other tasks make syscalls of their own while it sleeps in this one
+  task_current()->syscall_register_args = (command & ISR80H_REGISTER_ARGS) != 0;
+  res = isr80h_handle_command(command & ~ISR80H_REGISTER_ARGS, frame);
+  user_registers();
+  return res;
+}
+
+void *isr80h_sysenter_handler(int command, struct interrupt_frame_t *frame)
+{
+  void *res = 0;
+  kernel_registers();
+
+  // The ecx and edx arguments were left on the user stack, never trust the pointer to it
+  uint32_t args[2];
+  if (copy_from_user(task_current(), args, (void *)frame->esp, sizeof(args)) < 0)
+  {
+    user_registers();
+    return ERROR(-EINVARG);
+  }
+
+  frame->ecx = args[0];
+  frame->edx = args[1];
   task_current_save_state(frame);
-  res = isr80h_handle_command(command, frame);
-  switch_to_task_page();
+  // Fast entries always pass their arguments in registers
+  res = isr80h_handle_register_command(command & ~ISR80H_REGISTER_ARGS, frame);
+  user_registers();
   return res;
-}
\ No newline at end of file
+}
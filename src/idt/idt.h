@@ -2,12 +2,18 @@
 #define IDT_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 struct interrupt_frame_t;
 
 typedef void *(*isr80h_cmd_t)(struct interrupt_frame_t *frame);
 typedef void (*interrupt_callback_t)();
 
+// Hardware IRQs are remapped to the interrupts right after the processor exceptions
+#define IDT_IRQ_BASE 0x20
+#define IDT_IRQ_SLAVE_BASE 0x28
+#define IDT_TOTAL_IRQS 16
+
 struct idt_entry_t
 {
   uint16_t offset_1; // Offset bits 0 - 15
@@ -41,10 +47,19 @@ struct interrupt_frame_t
 } __attribute__((packed));
 
 void init_idt();
+void init_sysenter(uint32_t kernel_stack);
+bool idt_sysenter_enabled();
 extern void enable_interrupts();
 extern void disable_interrupts();
+extern void wait_for_interrupt();
 
 void isr80h_register_command(int id, isr80h_cmd_t command);
+void *isr80h_get_argument(struct interrupt_frame_t *frame, int index);
+void *isr80h_handle_register_command(int command, struct interrupt_frame_t *frame);
 int idt_register_interrupt_callback(int interrupt, interrupt_callback_t interrupt_callback);
+interrupt_callback_t idt_get_interrupt_callback(int interrupt);
+void idt_clock_stop();
+void idt_clock_start();
+void idt_irq_enable(int irq);
 
 #endif
@@ -1,4 +1,4 @@
-; This code defines four functions (read_byte, read_word, write_byte, write_word) that perform I/O operations based on the cdecl calling convention. 
+; This code defines the port I/O functions (read_byte, read_word, read_dword, write_byte, write_word, write_dword) that perform I/O operations based on the cdecl calling convention. 
 ; The code follows the standard function prologue and epilogue, preserving the base pointer (ebp) and restoring it before returning from each function. 
 ; The I/O operations involve reading or writing from ports specified by the function arguments ([ebp+8] and [ebp+12]).
 section .asm ; Defines the section of the assembly code
@@ -7,6 +7,9 @@ global read_byte
 global read_word
 global write_byte
 global write_word
+global read_dword
+global write_dword
+global read_tsc
 
 read_byte:
     push ebp ; Preserve the value of the base pointer (ebp) by pushing it onto the stack
@@ -51,3 +54,28 @@ write_word:
 
     pop ebp ; Restore the previous base pointer value by popping it from the stack
     ret ; Return from the function, popping the return address from the stack and transferring control back
+
+read_dword:
+    push ebp ; Preserve the value of the base pointer (ebp) by pushing it onto the stack
+    mov ebp, esp ; Set up a new base pointer (ebp) by copying the current stack pointer (esp)
+
+    mov edx, [ebp+8] ; Move the value at [ebp+8] (first function argument) into the edx register
+    in eax, dx ; Read a double word from the port specified by the value in edx and store it in the eax register
+
+    pop ebp ; Restore the previous base pointer value by popping it from the stack
+    ret ; Return from the function, popping the return address from the stack and transferring control back
+
+write_dword:
+    push ebp ; Preserve the value of the base pointer (ebp) by pushing it onto the stack
+    mov ebp, esp ; Set up a new base pointer (ebp) by copying the current stack pointer (esp)
+
+    mov eax, [ebp+12] ; Move the value at [ebp+12] (second function argument) into the eax register
+    mov edx, [ebp+8] ; Move the value at [ebp+8] (first function argument) into the edx register
+    out dx, eax ; Write the 32 bits of eax to the port specified by the value in edx
+
+    pop ebp ; Restore the previous base pointer value by popping it from the stack
+    ret ; Return from the function, popping the return address from the stack and transferring control back
+
+read_tsc:
+    rdtsc ; Read the time stamp counter into edx:eax, which is where cdecl returns a 64 bit value
+    ret ; Return from the function, popping the return address from the stack and transferring control back
@@ -6,6 +6,11 @@ extern uint8_t read_byte(uint16_t port);
 extern uint16_t read_word(uint16_t port);
 
 extern void write_byte(uint16_t port, uint8_t value);
-extern void wite_word(uint16_t port, uint16_t value);
+extern void write_word(uint16_t port, uint16_t value);
+
+extern uint32_t read_dword(uint16_t port);
+extern void write_dword(uint16_t port, uint32_t value);
+
+extern uint64_t read_tsc();
 
 #endif // IO_H
@@ -0,0 +1,35 @@
+#include "clock.h"
+#include "idt/idt.h"
+#include "task/task.h"
+#include "timer/timer.h"
+#include "kernel/kernel.h"
+
+// Copy the time of a clock into a user timespec, only the monotonic clock exists
+void *isr80h_clock_cmd_gettime(struct interrupt_frame_t *frame)
+{
+  int clock = (int)isr80h_get_argument(frame, 0);
+  void *user_ts = isr80h_get_argument(frame, 1);
+  if (clock != CLOCK_MONOTONIC)
+  {
+    return ERROR(-EINVARG);
+  }
+
+  struct timespec_t ts;
+  timer_ns_to_timespec(timer_now_ns(), &ts);
+  return ERROR(copy_to_user(task_current(), user_ts, &ts, sizeof(ts)));
+}
+
+// Put the calling task to sleep for a number of nanoseconds passed as two 32 bit halves
+void *isr80h_clock_cmd_sleep(struct interrupt_frame_t *frame)
+{
+  uint32_t ns_low = (uint32_t)isr80h_get_argument(frame, 0);
+  uint32_t ns_high = (uint32_t)isr80h_get_argument(frame, 1);
+  uint64_t ns = ((uint64_t)ns_high << 32) | ns_low;
+  if (ns == 0)
+  {
+    return 0;
+  }
+
+  task_sleep(ns);
+  return 0;
+}
@@ -0,0 +1,8 @@
+#ifndef ISR80H_CLOCK_H
+#define ISR80H_CLOCK_H
+
+struct interrupt_frame_t;
+void *isr80h_clock_cmd_gettime(struct interrupt_frame_t *frame);
+void *isr80h_clock_cmd_sleep(struct interrupt_frame_t *frame);
+
+#endif
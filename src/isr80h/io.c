@@ -2,12 +2,19 @@
 #include "task/task.h"
 #include "drivers/keyboard/keyboard.h"
 #include "kernel/kernel.h"
+#include "idt/idt.h"
+#include "task/process.h"
+#include "task/waitqueue.h"
+#include "disk/cache.h"
 
 void *isr80h_io_cmd_print(struct interrupt_frame_t *frame)
 {
-  void *user_space_msg_buffer = task_get_stack_item(task_current(), 0);
+  void *user_space_msg_buffer = isr80h_get_argument(frame, 0);
   char buf[1024];
-  copy_string_from_task(task_current(), user_space_msg_buffer, buf, sizeof(buf));
+  if (strncpy_from_user(task_current(), buf, user_space_msg_buffer, sizeof(buf)) < 0)
+  {
+    return ERROR(-EINVARG);
+  }
 
   print(buf);
   return 0;
@@ -21,7 +28,31 @@ void *isr80h_io_cmd_getkey(struct interrupt_frame_t *frame)
 
 void *isr80h_io_cmd_putchar(struct interrupt_frame_t *frame)
 {
-  char c = (char)(int)task_get_stack_item(task_current(), 0);
+  char c = (char)(int)isr80h_get_argument(frame, 0);
   term_writechar(c);
   return 0;
-}
\ No newline at end of file
+}
+
+// Like getkey but the task sleeps until a key is pushed to its process instead of getting 0
+void *isr80h_io_cmd_getkey_block(struct interrupt_frame_t *frame)
+{
+  char c = keyboard_pop();
+  while (!c)
+  {
+    // The task sleeps right here on its own kernel stack, someone else may take the key first
+    wait_queue_sleep(&task_current()->process->keyboard_waiters);
+    c = keyboard_pop();
+  }
+
+  return (void *)((int)c);
+}
+
+// Copy the sector cache hit, miss and eviction counts out to the process
+void *isr80h_io_cmd_disk_cache_stats(struct interrupt_frame_t *frame)
+{
+  void *user_stats = isr80h_get_argument(frame, 0);
+
+  struct disk_cache_stats_t stats;
+  disk_cache_stats(&stats);
+  return ERROR(copy_to_user(task_current(), user_stats, &stats, sizeof(stats)));
+}
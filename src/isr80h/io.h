@@ -5,4 +5,6 @@ struct interrupt_frame_t;
 void *isr80h_io_cmd_print(struct interrupt_frame_t *frame);
 void *isr80h_io_cmd_getkey(struct interrupt_frame_t *frame);
 void *isr80h_io_cmd_putchar(struct interrupt_frame_t *frame);
+void *isr80h_io_cmd_getkey_block(struct interrupt_frame_t *frame);
+void *isr80h_io_cmd_disk_cache_stats(struct interrupt_frame_t *frame);
 #endif
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include "io.h"
 #include "memory.h"
 #include "process.h"
+#include "ring.h"
+#include "stats.h"
+#include "clock.h"
 
 void isr80h_hookup_commands()
 {
@@ -10,6 +13,8 @@ void isr80h_hookup_commands()
   isr80h_register_command(__SYS_IO_CMD_PRINT, isr80h_io_cmd_print);
   isr80h_register_command(__SYS_IO_CMD_GETKEY, isr80h_io_cmd_getkey);
   isr80h_register_command(__SYS_IO_CMD_PUTCHAR, isr80h_io_cmd_putchar);
+  isr80h_register_command(__SYS_IO_CMD_GETKEY_BLOCK, isr80h_io_cmd_getkey_block);
+  isr80h_register_command(__SYS_IO_CMD_DISK_CACHE_STATS, isr80h_io_cmd_disk_cache_stats);
 
   // Memory syscalls
   isr80h_register_command(__SYS_MEM_CMD_MALLOC, isr80h_mem_cmd_malloc);
@@ -20,4 +25,20 @@ void isr80h_hookup_commands()
   isr80h_register_command(__SYS_PROC_INVOKE_SYSTEM_COMMAND, isr80h_proc_cmd_invoke_system_command);
   isr80h_register_command(__SYS_PROC_GET_PROGRAM_ARGUMENTS, isr80h_proc_cmd_get_program_arguments);
   isr80h_register_command(__SYS_PROC_EXIT, isr80h_proc_cmd_exit);
+  isr80h_register_command(__SYS_PROC_NICE, isr80h_proc_cmd_nice);
+  isr80h_register_command(__SYS_PROC_IDLE_STATS, isr80h_proc_cmd_idle_stats);
+  isr80h_register_command(__SYS_PROC_SYSENTER_ENABLED, isr80h_proc_cmd_sysenter_enabled);
+
+  // Clock syscalls
+  isr80h_register_command(__SYS_CLOCK_GETTIME, isr80h_clock_cmd_gettime);
+  isr80h_register_command(__SYS_CLOCK_SLEEP, isr80h_clock_cmd_sleep);
+
+  // Batched syscalls
+  isr80h_register_command(__SYS_RING_SETUP, isr80h_ring_cmd_setup);
+  isr80h_register_command(__SYS_RING_ENTER, isr80h_ring_cmd_enter);
+
+#if ISR80H_SYSCALL_STATS
+  // Syscall statistics
+  isr80h_register_command(__SYS_STATS, isr80h_stats_cmd_get);
+#endif
 }
\ No newline at end of file
@@ -1,6 +1,13 @@
 #ifndef ISR80H_H
 #define ISR80H_H
 
+#include <stdint.h>
+
+// Set in eax alongside the command when the arguments are passed in ebx, ecx, edx, esi and edi.
+// Without it the arguments are read from the user stack (compatibility mode)
+#define ISR80H_REGISTER_ARGS 0x80000000
+#define ISR80H_MAX_REGISTER_ARGS 5
+
 enum system_cmd_t
 {
   __SYS_IO_CMD_PRINT,
@@ -13,7 +20,35 @@ enum system_cmd_t
   __SYS_PROC_PROCESS_LOAD_START,
   __SYS_PROC_INVOKE_SYSTEM_COMMAND,
   __SYS_PROC_GET_PROGRAM_ARGUMENTS,
-  __SYS_PROC_EXIT
+  __SYS_PROC_EXIT,
+
+  __SYS_RING_SETUP,
+  __SYS_RING_ENTER,
+
+  __SYS_STATS,
+
+  __SYS_PROC_NICE,
+
+  __SYS_IO_CMD_GETKEY_BLOCK,
+
+  __SYS_PROC_IDLE_STATS,
+
+  __SYS_CLOCK_GETTIME,
+  __SYS_CLOCK_SLEEP,
+
+  __SYS_PROC_SYSENTER_ENABLED,
+
+  __SYS_IO_CMD_DISK_CACHE_STATS
+};
+
+// Call count and TSC cycles spent in one syscall, copied out to user programs by __SYS_STATS
+struct isr80h_command_stats_t
+{
+  uint32_t calls;
+  uint32_t reserved;
+  uint64_t total_cycles;
+  uint64_t min_cycles;
+  uint64_t max_cycles;
 };
 
 void isr80h_hookup_commands();
@@ -5,12 +5,14 @@
 
 #include "common/system.h"
 #include "kernel/kernel.h"
+#include "idt/idt.h"
+#include "mm/heap/kernel_heap.h"
 
 void *isr80h_proc_cmd_process_load_start(struct interrupt_frame_t *frame)
 {
-  void *filename_user_ptr = task_get_stack_item(task_current(), 0);
+  void *filename_user_ptr = isr80h_get_argument(frame, 0);
   char filename[MAX_PATH];
-  int res = copy_string_from_task(task_current(), filename_user_ptr, filename, sizeof(filename));
+  int res = strncpy_from_user(task_current(), filename, filename_user_ptr, sizeof(filename));
   if (res < 0)
   {
     goto out;
@@ -18,7 +20,7 @@ void *isr80h_proc_cmd_process_load_start(struct interrupt_frame_t *frame)
 
   char path[MAX_PATH];
   strcpy(path, "0:/");
-  strcpy(path + 3, filename);
+  strncpy(path + 3, filename, sizeof(path) - 3);
 
   struct process_t *process = 0;
   res = process_load_switch(path, &process);
@@ -27,19 +29,63 @@ void *isr80h_proc_cmd_process_load_start(struct interrupt_frame_t *frame)
     goto out;
   }
 
-  task_switch(process->task);
-  task_return(&process->task->registers);
+  // Run the new program right away, we return to the caller when it is scheduled again
+  task_yield_to(process->task);
 
 out:
   return 0;
 }
 
+// Copy a command's argument list out of the task one node at a time, through its page tables.
+// Returns the number of arguments copied into the kernel array
+static int isr80h_copy_command_arguments(struct task_t *task, struct command_argument_t *user_arguments, struct command_argument_t *arguments)
+{
+  int total = 0;
+  struct command_argument_t *current = user_arguments;
+  while (current)
+  {
+    if (total == MAX_COMMAND_ARGUMENTS)
+    {
+      return -EINVARG;
+    }
+
+    struct command_argument_t *argument = &arguments[total];
+    if (strncpy_from_user(task, argument->argument, current->argument, sizeof(argument->argument)) < 0)
+    {
+      return -EINVARG;
+    }
+
+    if (copy_from_user(task, &current, &current->next, sizeof(current)) < 0)
+    {
+      return -EINVARG;
+    }
+
+    argument->next = 0;
+    if (total > 0)
+    {
+      arguments[total - 1].next = argument;
+    }
+
+    total++;
+  }
+
+  return total;
+}
+
 void *isr80h_proc_cmd_invoke_system_command(struct interrupt_frame_t *frame)
 {
-  struct command_argument_t *arguments = task_virtual_address_to_physical(task_current(), task_get_stack_item(task_current(), 0));
-  if (!arguments || strlen(arguments[0].argument) == 0)
+  struct process_t *process = 0;
+  struct command_argument_t *arguments = kernel_zalloc(sizeof(struct command_argument_t) * MAX_COMMAND_ARGUMENTS);
+  if (!arguments)
   {
-    return ERROR(-EINVARG);
+    return ERROR(-ENOMEM);
+  }
+
+  int res = isr80h_copy_command_arguments(task_current(), isr80h_get_argument(frame, 0), arguments);
+  if (res <= 0 || strlen(arguments[0].argument) == 0)
+  {
+    res = -EINVARG;
+    goto out;
   }
 
   struct command_argument_t *root_command_argument = &arguments[0];
@@ -47,33 +93,39 @@ void *isr80h_proc_cmd_invoke_system_command(struct interrupt_frame_t *frame)
 
   char path[MAX_PATH];
   strcpy(path, "0:/");
-  strncpy(path + 3, program_name, sizeof(path));
+  strncpy(path + 3, program_name, sizeof(path) - 3);
 
-  struct process_t *process = 0;
-  int res = process_load_switch(path, &process);
+  res = process_load_switch(path, &process);
   if (res < 0)
   {
-    return ERROR(res);
+    goto out;
   }
 
   res = process_inject_arguments(process, root_command_argument);
+
+out:
+  kernel_free(arguments);
   if (res < 0)
   {
     return ERROR(res);
   }
 
-  task_switch(process->task);
-  task_return(&process->task->registers);
-
+  task_yield_to(process->task);
   return 0;
 }
 
 void *isr80h_proc_cmd_get_program_arguments(struct interrupt_frame_t *frame)
 {
   struct process_t *process = task_current()->process;
-  struct process_arguments_t *arguments = task_virtual_address_to_physical(task_current(), task_get_stack_item(task_current(), 0));
+  void *user_arguments = isr80h_get_argument(frame, 0);
+
+  struct process_arguments_t arguments;
+  process_get_arguments(process, &arguments.argc, &arguments.argv);
+  if (copy_to_user(task_current(), user_arguments, &arguments, sizeof(arguments)) < 0)
+  {
+    return ERROR(-EINVARG);
+  }
 
-  process_get_arguments(process, &arguments->argc, &arguments->argv);
   return 0;
 }
 
@@ -83,4 +135,47 @@ void *isr80h_proc_cmd_exit(struct interrupt_frame_t *frame)
   process_terminate(process);
   task_next();
   return 0;
+}
+
+// Set the nice value of a process, a negative id means the calling process.
+// A process may only lower the priority of the others, never raise it
+void *isr80h_proc_cmd_nice(struct interrupt_frame_t *frame)
+{
+  int process_id = (int)isr80h_get_argument(frame, 0);
+  int nice = (int)isr80h_get_argument(frame, 1);
+
+  struct process_t *caller = task_current()->process;
+  struct process_t *process = caller;
+  if (process_id >= 0)
+  {
+    process = process_get(process_id);
+  }
+
+  if (!process)
+  {
+    return ERROR(-EINVARG);
+  }
+
+  if (process != caller && nice < process->task->nice)
+  {
+    return ERROR(-EINVARG);
+  }
+
+  return ERROR(task_set_nice(process->task, nice));
+}
+
+// Copy the cycles spent idle and in total since boot, the idle percentage is their ratio
+void *isr80h_proc_cmd_idle_stats(struct interrupt_frame_t *frame)
+{
+  void *user_stats = isr80h_get_argument(frame, 0);
+
+  struct task_idle_stats_t stats;
+  task_idle_stats(&stats);
+  return ERROR(copy_to_user(task_current(), user_stats, &stats, sizeof(stats)));
+}
+
+// Tell the stdlib whether it can use SYSENTER, the processor or the kernel may not support it
+void *isr80h_proc_cmd_sysenter_enabled(struct interrupt_frame_t *frame)
+{
+  return (void *)(idt_sysenter_enabled() ? 1 : 0);
 }
\ No newline at end of file
@@ -6,5 +6,8 @@ void *isr80h_proc_cmd_process_load_start(struct interrupt_frame_t *frame);
 void *isr80h_proc_cmd_invoke_system_command(struct interrupt_frame_t *frame);
 void *isr80h_proc_cmd_get_program_arguments(struct interrupt_frame_t *frame);
 void *isr80h_proc_cmd_exit(struct interrupt_frame_t *frame);
+void *isr80h_proc_cmd_nice(struct interrupt_frame_t *frame);
+void *isr80h_proc_cmd_idle_stats(struct interrupt_frame_t *frame);
+void *isr80h_proc_cmd_sysenter_enabled(struct interrupt_frame_t *frame);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "ring.h"
+#include "isr80h.h"
+#include "idt/idt.h"
+#include "task/task.h"
+#include "task/process.h"
+#include "kernel/kernel.h"
+#include <stdbool.h>
+
+// Only commands that return to the caller can be queued, anything that switches tasks has to trap on its own
+static bool isr80h_ring_command_allowed(uint32_t command)
+{
+  switch (command)
+  {
+  case __SYS_IO_CMD_PRINT:
+  case __SYS_IO_CMD_GETKEY:
+  case __SYS_IO_CMD_PUTCHAR:
+  case __SYS_MEM_CMD_MALLOC:
+  case __SYS_MEM_FREE:
+  case __SYS_PROC_GET_PROGRAM_ARGUMENTS:
+    return true;
+  }
+
+  return false;
+}
+
+// A queued free of the rings themselves would leave this loop writing completions into freed memory
+static bool isr80h_ring_command_frees_ring(struct syscall_ring_t *ring, struct syscall_ring_sqe_t *sqe)
+{
+  if (sqe->command != __SYS_MEM_FREE)
+  {
+    return false;
+  }
+
+  uint32_t ring_start = (uint32_t)ring;
+  uint32_t ring_end = ring_start + sizeof(struct syscall_ring_t);
+  return sqe->args[0] >= ring_start && sqe->args[0] < ring_end;
+}
+
+// Give the current process a pair of submission and completion rings mapped into its address space
+void *isr80h_ring_cmd_setup(struct interrupt_frame_t *frame)
+{
+  struct process_t *process = task_current()->process;
+  if (!process->syscall_ring)
+  {
+    process->syscall_ring = process_malloc(process, sizeof(struct syscall_ring_t));
+  }
+
+  return process->syscall_ring;
+}
+
+// Run every queued system call of the current process, returns the number of submissions consumed
+void *isr80h_ring_cmd_enter(struct interrupt_frame_t *frame)
+{
+  struct syscall_ring_t *ring = task_current()->process->syscall_ring;
+  if (!ring)
+  {
+    return ERROR(-EINVARG);
+  }
+
+  int consumed = 0;
+  uint32_t sq_tail = ring->sq_tail;
+  while (ring->sq_head != sq_tail)
+  {
+    // Stop once the process has to drain completions first
+    if (ring->cq_tail - ring->cq_head >= SYSCALL_RING_ENTRIES)
+    {
+      break;
+    }
+
+    struct syscall_ring_sqe_t *sqe = &ring->sq[ring->sq_head & SYSCALL_RING_MASK];
+    int32_t result = -EINVARG;
+    if (isr80h_ring_command_allowed(sqe->command) && !isr80h_ring_command_frees_ring(ring, sqe))
+    {
+      // Handlers read their arguments from the frame like a register based system call
+      struct interrupt_frame_t command_frame = *frame;
+      command_frame.ebx = sqe->args[0];
+      command_frame.ecx = sqe->args[1];
+      command_frame.edx = sqe->args[2];
+      command_frame.esi = sqe->args[3];
+      command_frame.edi = sqe->args[4];
+      result = (int32_t)isr80h_handle_register_command(sqe->command, &command_frame);
+
+      // The rings may have been released by the call, nothing of them can be touched anymore
+      if (task_current()->process->syscall_ring != ring)
+      {
+        break;
+      }
+    }
+
+    struct syscall_ring_cqe_t *cqe = &ring->cq[ring->cq_tail & SYSCALL_RING_MASK];
+    cqe->user_data = sqe->user_data;
+    cqe->result = result;
+
+    ring->cq_tail++;
+    ring->sq_head++;
+    consumed++;
+  }
+
+  return (void *)consumed;
+}
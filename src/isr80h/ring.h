@@ -0,0 +1,42 @@
+#ifndef ISR80H_RING_H
+#define ISR80H_RING_H
+
+#include <stdint.h>
+
+// Entries in each ring, a power of two so the free running indexes wrap with a mask
+#define SYSCALL_RING_ENTRIES 64
+#define SYSCALL_RING_MASK (SYSCALL_RING_ENTRIES - 1)
+
+// A queued system call, the arguments are the ones passed in ebx, ecx, edx, esi and edi
+struct syscall_ring_sqe_t
+{
+  uint32_t command;
+  uint32_t args[5];
+  uint32_t user_data;
+};
+
+// The result of a queued system call, user_data is copied from its submission
+struct syscall_ring_cqe_t
+{
+  uint32_t user_data;
+  int32_t result;
+};
+
+// Submission and completion rings shared with the process, the process produces at sq_tail
+// and consumes at cq_head, the kernel consumes at sq_head and produces at cq_tail
+struct syscall_ring_t
+{
+  volatile uint32_t sq_head;
+  volatile uint32_t sq_tail;
+  volatile uint32_t cq_head;
+  volatile uint32_t cq_tail;
+
+  struct syscall_ring_sqe_t sq[SYSCALL_RING_ENTRIES];
+  struct syscall_ring_cqe_t cq[SYSCALL_RING_ENTRIES];
+};
+
+struct interrupt_frame_t;
+void *isr80h_ring_cmd_setup(struct interrupt_frame_t *frame);
+void *isr80h_ring_cmd_enter(struct interrupt_frame_t *frame);
+
+#endif
@@ -0,0 +1,100 @@
+#include "stats.h"
+
+#if ISR80H_SYSCALL_STATS
+#include "idt/idt.h"
+#include "task/task.h"
+#include "task/process.h"
+#include "kernel/kernel.h"
+#include "mm/memory.h"
+
+// The syscalls made by every process since boot
+static struct isr80h_command_stats_t isr80h_stats[ISR80H_STATS_MAX_COMMANDS];
+
+void isr80h_stats_init()
+{
+  memset(isr80h_stats, 0, sizeof(isr80h_stats));
+}
+
+void isr80h_stats_count(int command, struct process_t *process)
+{
+  if (command >= ISR80H_STATS_MAX_COMMANDS)
+  {
+    return;
+  }
+
+  isr80h_stats[command].calls++;
+  if (process)
+  {
+    process->syscall_stats[command].calls++;
+  }
+}
+
+static void isr80h_stats_add_cycles(struct isr80h_command_stats_t *stats, uint64_t cycles)
+{
+  stats->total_cycles += cycles;
+  if (!stats->min_cycles || cycles < stats->min_cycles)
+  {
+    stats->min_cycles = cycles;
+  }
+
+  if (cycles > stats->max_cycles)
+  {
+    stats->max_cycles = cycles;
+  }
+}
+
+void isr80h_stats_time(int command, struct process_t *process, uint64_t cycles)
+{
+  if (command >= ISR80H_STATS_MAX_COMMANDS)
+  {
+    return;
+  }
+
+  isr80h_stats_add_cycles(&isr80h_stats[command], cycles);
+
+  // The process may have exited during the call
+  if (process && task_current() && task_current()->process == process)
+  {
+    isr80h_stats_add_cycles(&process->syscall_stats[command], cycles);
+  }
+}
+
+// Copy the statistics of a process, or of the whole system for a negative id, into a user array
+// of at most max entries indexed by command. Returns the number of entries copied
+void *isr80h_stats_cmd_get(struct interrupt_frame_t *frame)
+{
+  int process_id = (int)isr80h_get_argument(frame, 0);
+  void *user_stats = isr80h_get_argument(frame, 1);
+  int max = (int)isr80h_get_argument(frame, 2);
+
+  struct isr80h_command_stats_t *stats = isr80h_stats;
+  if (process_id >= 0)
+  {
+    struct process_t *process = process_get(process_id);
+    if (!process)
+    {
+      return ERROR(-EINVARG);
+    }
+
+    stats = process->syscall_stats;
+  }
+
+  if (max <= 0)
+  {
+    return ERROR(-EINVARG);
+  }
+
+  if (max > ISR80H_STATS_MAX_COMMANDS)
+  {
+    max = ISR80H_STATS_MAX_COMMANDS;
+  }
+
+  int res = copy_to_user(task_current(), user_stats, stats, max * sizeof(struct isr80h_command_stats_t));
+  if (res < 0)
+  {
+    return ERROR(res);
+  }
+
+  return (void *)max;
+}
+#endif
@@ -0,0 +1,17 @@
+#ifndef ISR80H_STATS_H
+#define ISR80H_STATS_H
+
+#include "common/system.h"
+#include "isr80h.h"
+
+#if ISR80H_SYSCALL_STATS
+struct process_t;
+struct interrupt_frame_t;
+
+void isr80h_stats_init();
+void isr80h_stats_count(int command, struct process_t *process);
+void isr80h_stats_time(int command, struct process_t *process, uint64_t cycles);
+void *isr80h_stats_cmd_get(struct interrupt_frame_t *frame);
+#endif
+
+#endif
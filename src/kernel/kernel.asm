@@ -40,10 +40,30 @@ _start:
     mov al, 0x20         ; Set the interrupt vector offset for the master ISR
     out 0x21, al         ; Send the offset to the master PIC port
 
+    mov al, 00000100b    ; The slave PIC is cascaded on IRQ 2 of the master
+    out 0x21, al         ; Send the cascade setup to the master PIC port
+
     mov al, 00000001b    ; Set the initialization command for the master PIC
     out 0x21, al         ; Send the command to the master PIC port
     ; End remap of the master PIC
 
+    ; Remap the slave PIC right after the master, IRQ 8-15 become interrupts 0x28-0x2F
+    mov al, 00010001b    ; Set the initialization command for the slave PIC
+    out 0xA0, al         ; Send the command to the slave PIC port
+
+    mov al, 0x28         ; Set the interrupt vector offset for the slave ISR
+    out 0xA1, al         ; Send the offset to the slave PIC port
+
+    mov al, 00000010b    ; Tell the slave its cascade identity on the master
+    out 0xA1, al         ; Send the cascade identity to the slave PIC port
+
+    mov al, 00000001b    ; Set the initialization command for the slave PIC
+    out 0xA1, al         ; Send the command to the slave PIC port
+
+    mov al, 0xFF         ; Mask every slave IRQ, drivers unmask the ones they handle
+    out 0xA1, al         ; Send the mask to the slave PIC port
+    ; End remap of the slave PIC
+
     call start_kernel     ; Call the kernel_main function
 
     jmp $                ; Endless loop (halt execution)
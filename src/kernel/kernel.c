@@ -4,7 +4,10 @@
 #include <kernel/kernel.h>
 #include <disk/disk.h>
 #include <fs/parser.h>
+#include <disk/stream.h>
+#include <disk/cache.h>
 #include <idt/idt.h>
+#include <timer/timer.h>
 #include <task/tss.h>
 #include <task/process.h>
 #include <gdt/gdt.h>
@@ -12,10 +15,31 @@
 #include <isr80h/isr80h.h>
 #include <mm/memory.h>
 #include <mm/heap/kernel_heap.h>
+#include <mm/slab/slab.h>
 #include <mm/paging/paging.h>
 #include <mm/blkm/blkm.h>
 #include <string/string.h>
 #include <drivers/keyboard/keyboard.h>
+#include <drivers/pci/pci.h>
+#include <drivers/ata/ata.h>
+
+// The frame pool runs from BLKM_ADDRESS to the end of the installed memory, at most BLKM_SIZE_BYTES
+static size_t kernel_frame_pool_size()
+{
+  uint32_t memory_end = mem_installed_end();
+  if (memory_end < BLKM_ADDRESS + BLKM_MIN_SIZE_BYTES + BLKM_FIRMWARE_RESERVE_BYTES)
+  {
+    PANIC("Not enough memory, at least 73MB are needed\n");
+  }
+
+  uint32_t pool_end = memory_end - BLKM_FIRMWARE_RESERVE_BYTES;
+  if (pool_end > BLKM_ADDRESS + BLKM_SIZE_BYTES)
+  {
+    pool_end = BLKM_ADDRESS + BLKM_SIZE_BYTES;
+  }
+
+  return pool_end - BLKM_ADDRESS;
+}
 
 uint16_t *vram = 0;
 uint16_t t_row = 0;
@@ -164,32 +188,66 @@ void start_kernel()
   // Load the gdt
   gdt_load(sizeof(gdt_entries), gdt_entries);
 
+  // Initialize the physical frame allocator
+  mem_init((uint8_t *)BLKM_ADDRESS, kernel_frame_pool_size());
+
   // Initialize the heap
   kernel_heap_init();
 
+  // Initialize the task caches
+  task_cache_init();
+
   // Initialize filesystems
   fs_init();
 
+  // Initialize the disk streams
+  disk_stream_init();
+
+  // Initialize the disk block cache, the filesystems read through it
+  disk_cache_init();
+
+  // Find the devices on the PCI bus
+  pci_init();
+
+  // Calibrate the TSC and program the clock interrupt rate, disk commands are timed against it
+  timer_init();
+
   // Search and initialize the disks
   disk_search_and_init();
 
   // Initialize the interrupt descriptor table
   init_idt();
 
+#if ATA_BOOT_BENCHMARK
+  // Compare PIO and DMA reads now that there is a clock to time them
+  ata_benchmark();
+#endif
+
   // Setup the TSS
   memset(&kernel_tss, 0x00, sizeof(kernel_tss));
+  // Each task points esp0 at its own kernel stack when it is switched to
   kernel_tss.esp0 = 0x600000;
   kernel_tss.ss0 = KERNEL_DATA_SELECTOR;
   // Load the TSS
   tss_load(0x28);
 
-  // Setup paging
-  kernel_chunk = paging_new_4GB(PAGING_IS_WRITEABLE | PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL);
+  // Setup the SYSENTER fast system call entry
+  init_sysenter(kernel_tss.esp0);
+
+  // Use 4MB and global pages for the kernel identity map where possible
+  paging_enable_large_pages();
+  paging_enable_global_pages();
+
+  // Setup paging, the kernel mappings are shared with every task so they stay supervisor only
+  kernel_chunk = paging_new_kernel_4GB();
   // Switch to kernel paging chunk
   paging_switch(kernel_chunk);
   // Enable paging
   enable_paging();
 
+  // Create the task that runs when every other one is blocked
+  task_idle_init(kernel_chunk);
+
   // Register the kernel commands
   isr80h_hookup_commands();
 
@@ -2,6 +2,9 @@
 
 section .asm
 
+; Arguments are passed in ebx, ecx, edx, esi and edi, syscalls without this flag read them from the stack
+%define SYSCALL_REGISTER_ARGS 0x80000000
+
 global print:function
 global sys_getkey:function
 global sys_malloc:function
@@ -11,89 +14,232 @@ global sys_process_load_start:function
 global sys_process_get_arguments:function 
 global sys_system:function
 global sys_exit:function
+global sys_ring_setup:function
+global sys_ring_enter:function
+global sys_stats:function
+global sys_nice:function
+global sys_getkey_block:function
+global sys_idle_stats:function
+global sys_clock_gettime:function
+global sys_sleep:function
+global sys_sysenter_enabled:function
+global sys_disk_cache_stats:function
+
+; Non zero once c_start has asked the kernel, until then and on processors without it calls go through int 0x80
+extern sysenter_enabled
 
 print:
     push ebp
     mov ebp, esp
-    push dword[ebp+8]
-    mov eax, 0 ; Command print
+    push ebx
+    mov ebx, [ebp+8]
+    mov eax, SYSCALL_REGISTER_ARGS | 0 ; Command print
     int 0x80
-    add esp, 4
+    pop ebx
     pop ebp
     ret
 
 sys_getkey:
     push ebp
     mov ebp, esp
-    mov eax, 1 ; Command getkey
-    int 0x80
+    mov eax, SYSCALL_REGISTER_ARGS | 1 ; Command getkey
+    call sysenter_call
     pop ebp
     ret
 
 sys_putchar:
     push ebp
     mov ebp, esp
-    mov eax, 2 ; Command putchar
-    push dword [ebp+8] ; Variable "c"
-    int 0x80
-    add esp, 4
+    push ebx
+    mov eax, SYSCALL_REGISTER_ARGS | 2 ; Command putchar
+    mov ebx, [ebp+8] ; Variable "c"
+    call sysenter_call
+    pop ebx
     pop ebp
     ret
 
+; Enter the kernel through SYSENTER, eax holds the command and ebx, ecx, edx, esi, edi the arguments.
+; The processor saves neither the return address nor the stack, so they travel in edx and ecx
+; and the ecx and edx arguments are left on the stack for the kernel
+sysenter_call:
+    cmp dword [sysenter_enabled], 0
+    je .interrupt
+    push edx
+    push ecx
+    mov ecx, esp
+    mov edx, .return
+    sysenter
+.return:
+    add esp, 8
+    ret
+.interrupt:
+    int 0x80 ; Same register arguments, the kernel did not enable SYSENTER
+    ret
+
 sys_malloc:
     push ebp
     mov ebp, esp
-    mov eax, 3 ; Command malloc (Allocates memory for the process)
-    push dword[ebp+8] ; Variable "size"
+    push ebx
+    mov eax, SYSCALL_REGISTER_ARGS | 3 ; Command malloc (Allocates memory for the process)
+    mov ebx, [ebp+8] ; Variable "size"
     int 0x80
-    add esp, 4
+    pop ebx
     pop ebp
     ret
 
 sys_free:
     push ebp
     mov ebp, esp
-    mov eax, 4 ; Command 4 free (Frees the allocated memory for this process)
-    push dword[ebp+8] ; Variable "ptr"
+    push ebx
+    mov eax, SYSCALL_REGISTER_ARGS | 4 ; Command 4 free (Frees the allocated memory for this process)
+    mov ebx, [ebp+8] ; Variable "ptr"
     int 0x80
-    add esp, 4
+    pop ebx
     pop ebp
     ret
 
 sys_process_load_start:
     push ebp
     mov ebp, esp
-    mov eax, 5 ; Command 5 process load start ( stars a process )
-    push dword[ebp+8] ; Variable "filename"
+    push ebx
+    mov eax, SYSCALL_REGISTER_ARGS | 5 ; Command 5 process load start ( stars a process )
+    mov ebx, [ebp+8] ; Variable "filename"
     int 0x80
-    add esp, 4
+    pop ebx
     pop ebp
     ret
 
 sys_system:
     push ebp
     mov ebp, esp
-    mov eax, 6 ; Command 6 process_system ( runs a system command based on the arguments)
-    push dword[ebp+8] ; Variable "arguments"
+    push ebx
+    mov eax, SYSCALL_REGISTER_ARGS | 6 ; Command 6 process_system ( runs a system command based on the arguments)
+    mov ebx, [ebp+8] ; Variable "arguments"
     int 0x80
-    add esp, 4
+    pop ebx
     pop ebp
     ret
 
 sys_process_get_arguments:
     push ebp
     mov ebp, esp
-    mov eax, 7 ; Command 7 Gets the process arguments
-    push dword[ebp+8] ; Variable arguments
+    push ebx
+    mov eax, SYSCALL_REGISTER_ARGS | 7 ; Command 7 Gets the process arguments
+    mov ebx, [ebp+8] ; Variable arguments
     int 0x80
-    add esp, 4
+    pop ebx
     pop ebp
     ret
 
 sys_exit:
     push ebp
     mov ebp, esp
-    mov eax, 8 ; Command 8 process exit
+    mov eax, SYSCALL_REGISTER_ARGS | 8 ; Command 8 process exit
+    int 0x80
+    pop ebp
+    ret
+
+sys_ring_setup:
+    push ebp
+    mov ebp, esp
+    mov eax, SYSCALL_REGISTER_ARGS | 9 ; Command 9 maps the batched syscall rings
+    int 0x80
+    pop ebp
+    ret
+
+sys_ring_enter:
+    push ebp
+    mov ebp, esp
+    mov eax, SYSCALL_REGISTER_ARGS | 10 ; Command 10 runs the queued syscalls
     int 0x80
     pop ebp
-    ret
\ No newline at end of file
+    ret
+
+sys_stats:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, SYSCALL_REGISTER_ARGS | 11 ; Command 11 copies out the syscall statistics
+    mov ebx, [ebp+8] ; Variable "process_id"
+    mov ecx, [ebp+12] ; Variable "stats"
+    mov edx, [ebp+16] ; Variable "max"
+    int 0x80
+    pop ebx
+    pop ebp
+    ret
+
+sys_nice:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, SYSCALL_REGISTER_ARGS | 12 ; Command 12 sets the nice value of a process
+    mov ebx, [ebp+8] ; Variable "process_id"
+    mov ecx, [ebp+12] ; Variable "nice"
+    int 0x80
+    pop ebx
+    pop ebp
+    ret
+
+; Sleeps until a key is pressed. The kernel waits on the task's own kernel stack and returns
+; from the same entry once woken, so the fast entry works here like it does for getkey
+sys_getkey_block:
+    push ebp
+    mov ebp, esp
+    mov eax, SYSCALL_REGISTER_ARGS | 13 ; Command 13 getkey, blocking
+    call sysenter_call
+    pop ebp
+    ret
+
+sys_idle_stats:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, SYSCALL_REGISTER_ARGS | 14 ; Command 14 copies out the idle time
+    mov ebx, [ebp+8] ; Variable "stats"
+    int 0x80
+    pop ebx
+    pop ebp
+    ret
+
+sys_clock_gettime:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, SYSCALL_REGISTER_ARGS | 15 ; Command 15 reads a clock
+    mov ebx, [ebp+8] ; Variable "clock"
+    mov ecx, [ebp+12] ; Variable "ts"
+    int 0x80
+    pop ebx
+    pop ebp
+    ret
+
+sys_sleep:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, SYSCALL_REGISTER_ARGS | 16 ; Command 16 sleeps
+    mov ebx, [ebp+8] ; Low half of "ns"
+    mov ecx, [ebp+12] ; High half of "ns"
+    int 0x80
+    pop ebx
+    pop ebp
+    ret
+
+sys_sysenter_enabled:
+    push ebp
+    mov ebp, esp
+    mov eax, SYSCALL_REGISTER_ARGS | 17 ; Command 17 whether SYSENTER can be used
+    int 0x80
+    pop ebp
+    ret
+
+sys_disk_cache_stats:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, SYSCALL_REGISTER_ARGS | 18 ; Command 18 copies out the disk cache counters
+    mov ebx, [ebp+8] ; Variable "stats"
+    int 0x80
+    pop ebx
+    pop ebp
+    ret
@@ -73,16 +73,8 @@ out:
 // Function to get a key press, blocking until one is received
 int sys_getkeyblock()
 {
-  // Initialize the key value
-  int val = 0;
-  // Loop until a key is pressed
-  do
-  {
-    // Get the key press
-    val = sys_getkey();
-  } while (val == 0);
-  // Return the key value
-  return val;
+  // The kernel puts us to sleep until a key is pressed
+  return sys_getkey_block();
 }
 
 // Function to read a line from the terminal
@@ -2,6 +2,7 @@
 #define STDLIB_OS_H
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 struct command_argument_t
 {
@@ -15,6 +16,16 @@ struct process_arguments_t
   char **argv;
 };
 
+// Call count and TSC cycles spent in one syscall
+struct syscall_stats_t
+{
+  uint32_t calls;
+  uint32_t reserved;
+  uint64_t total_cycles;
+  uint64_t min_cycles;
+  uint64_t max_cycles;
+};
+
 extern void print(const char *filename);
 extern int sys_getkey();
 extern void *sys_malloc(size_t size);
@@ -24,6 +35,38 @@ extern void sys_process_load_start(const char *filename);
 extern void sys_process_get_arguments(struct process_arguments_t *arguments);
 extern int sys_system(struct command_argument_t *arguments);
 extern void sys_exit();
+// Cycles spent idle and in total since boot
+struct idle_stats_t
+{
+  uint64_t total_cycles;
+  uint64_t idle_cycles;
+};
+
+// Nanoseconds since boot, it never goes backwards
+#define CLOCK_MONOTONIC 0
+
+struct timespec_t
+{
+  uint32_t tv_sec;
+  uint32_t tv_nsec;
+};
+
+// Sector cache lookups since boot
+struct disk_cache_stats_t
+{
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+};
+
+extern int sys_stats(int process_id, struct syscall_stats_t *stats, int max);
+extern int sys_nice(int process_id, int nice);
+extern int sys_getkey_block();
+extern int sys_idle_stats(struct idle_stats_t *stats);
+extern int sys_clock_gettime(int clock, struct timespec_t *ts);
+extern int sys_sleep(uint64_t ns);
+extern int sys_sysenter_enabled();
+extern int sys_disk_cache_stats(struct disk_cache_stats_t *stats);
 
 int sys_getkeyblock();
 void sys_terminal_readline(char *out, int max, bool output_while_typing);
@@ -0,0 +1,74 @@
+#include "ring.h"
+
+// Map the rings of this process, calling it again returns the same rings
+struct syscall_ring_t *ring_init()
+{
+  return sys_ring_setup();
+}
+
+// Queue a system call, returns false when the submission ring is full
+bool ring_submit(struct syscall_ring_t *ring, uint32_t command, uint32_t arg, uint32_t user_data)
+{
+  if (ring->sq_tail - ring->sq_head >= SYSCALL_RING_ENTRIES)
+  {
+    return false;
+  }
+
+  struct syscall_ring_sqe_t *sqe = &ring->sq[ring->sq_tail & SYSCALL_RING_MASK];
+  sqe->command = command;
+  sqe->args[0] = arg;
+  sqe->args[1] = 0;
+  sqe->args[2] = 0;
+  sqe->args[3] = 0;
+  sqe->args[4] = 0;
+  sqe->user_data = user_data;
+  ring->sq_tail++;
+  return true;
+}
+
+// Run everything queued so far in a single kernel entry, returns the number of system calls executed
+int ring_flush(struct syscall_ring_t *ring)
+{
+  return sys_ring_enter();
+}
+
+// Take the next completion, returns false when there is none
+bool ring_complete(struct syscall_ring_t *ring, struct syscall_ring_cqe_t *out)
+{
+  if (ring->cq_head == ring->cq_tail)
+  {
+    return false;
+  }
+
+  *out = ring->cq[ring->cq_head & SYSCALL_RING_MASK];
+  ring->cq_head++;
+  return true;
+}
+
+// Queue a character for the terminal, flushing first when the rings are full
+void ring_putchar(struct syscall_ring_t *ring, char c)
+{
+  struct syscall_ring_cqe_t cqe;
+  while (!ring_submit(ring, SYSCALL_RING_PUTCHAR, (uint32_t)c, 0))
+  {
+    ring_flush(ring);
+    while (ring_complete(ring, &cqe))
+    {
+    }
+  }
+}
+
+// Queue a string one character at a time and write it out in as few kernel entries as possible
+void ring_print(struct syscall_ring_t *ring, const char *str)
+{
+  struct syscall_ring_cqe_t cqe;
+  while (*str)
+  {
+    ring_putchar(ring, *str++);
+  }
+
+  ring_flush(ring);
+  while (ring_complete(ring, &cqe))
+  {
+  }
+}
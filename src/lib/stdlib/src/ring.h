@@ -0,0 +1,52 @@
+#ifndef STDLIB_RING_H
+#define STDLIB_RING_H
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SYSCALL_RING_ENTRIES 64
+#define SYSCALL_RING_MASK (SYSCALL_RING_ENTRIES - 1)
+
+// Commands that can be queued on the rings
+#define SYSCALL_RING_PRINT 0
+#define SYSCALL_RING_GETKEY 1
+#define SYSCALL_RING_PUTCHAR 2
+#define SYSCALL_RING_MALLOC 3
+#define SYSCALL_RING_FREE 4
+#define SYSCALL_RING_GET_PROGRAM_ARGUMENTS 7
+
+struct syscall_ring_sqe_t
+{
+  uint32_t command;
+  uint32_t args[5];
+  uint32_t user_data;
+};
+
+struct syscall_ring_cqe_t
+{
+  uint32_t user_data;
+  int32_t result;
+};
+
+// Shared with the kernel, we produce at sq_tail and consume at cq_head
+struct syscall_ring_t
+{
+  volatile uint32_t sq_head;
+  volatile uint32_t sq_tail;
+  volatile uint32_t cq_head;
+  volatile uint32_t cq_tail;
+
+  struct syscall_ring_sqe_t sq[SYSCALL_RING_ENTRIES];
+  struct syscall_ring_cqe_t cq[SYSCALL_RING_ENTRIES];
+};
+
+extern struct syscall_ring_t *sys_ring_setup();
+extern int sys_ring_enter();
+
+struct syscall_ring_t *ring_init();
+bool ring_submit(struct syscall_ring_t *ring, uint32_t command, uint32_t arg, uint32_t user_data);
+int ring_flush(struct syscall_ring_t *ring);
+bool ring_complete(struct syscall_ring_t *ring, struct syscall_ring_cqe_t *out);
+void ring_putchar(struct syscall_ring_t *ring, char c);
+void ring_print(struct syscall_ring_t *ring, const char *str);
+
+#endif
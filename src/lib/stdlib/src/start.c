@@ -2,8 +2,13 @@
 
 extern int main(int argc, char **argv);
 
+// Read by sysenter_call in os.asm
+int sysenter_enabled = 0;
+
 void c_start()
 {
+  sysenter_enabled = sys_sysenter_enabled();
+
   struct process_arguments_t arguments;
   sys_process_get_arguments(&arguments);
 
@@ -224,7 +224,7 @@ int elf_load(const char *filename, struct elf_file_t **file_out)
     goto out;
   }
 
-  elf_file->elf_memory = kernel_zalloc(stat.filesize);
+  elf_file->elf_memory = kernel_zalloc_pages(stat.filesize);
   res = fread(elf_file->elf_memory, stat.filesize, 1, fd);
   if (res < 0)
   {
@@ -1,76 +1,199 @@
-
 #include "blkm.h"
 #include "mm/memory.h"
 #include "common/system.h"
+#include "io/io.h"
+
+#define BLKM_TOTAL_FRAMES (BLKM_SIZE_BYTES / BLKM_FRAME_SIZE)
+
+uint8_t *memory; // The memory managed by the allocator
+
+// Order of every block on its first frame, with BLKM_FRAME_FREE set while it is free
+static uint8_t frame_map[BLKM_TOTAL_FRAMES];
+static uint32_t total_frames;
+static uint32_t free_frames;
+
+// One free list per order and a bitmap of the non empty ones
+static struct blkm_free_block_t *free_lists[BLKM_TOTAL_ORDERS];
+static uint32_t free_lists_bitmap;
+
+static struct blkm_free_block_t *frame_to_block(uint32_t frame)
+{
+  return (struct blkm_free_block_t *)&memory[frame * BLKM_FRAME_SIZE];
+}
+
+static uint32_t block_to_frame(void *block)
+{
+  return ((uint8_t *)block - memory) / BLKM_FRAME_SIZE;
+}
+
+static void free_list_push(uint32_t frame, int order)
+{
+  struct blkm_free_block_t *block = frame_to_block(frame);
+  block->prev = 0;
+  block->next = free_lists[order];
+  if (block->next)
+  {
+    block->next->prev = block;
+  }
+
+  free_lists[order] = block;
+  free_lists_bitmap |= (1U << order);
+  frame_map[frame] = BLKM_FRAME_FREE | order;
+}
+
+static void free_list_remove(uint32_t frame, int order)
+{
+  struct blkm_free_block_t *block = frame_to_block(frame);
+  if (block->prev)
+  {
+    block->prev->next = block->next;
+  }
+  else
+  {
+    free_lists[order] = block->next;
+  }
+
+  if (block->next)
+  {
+    block->next->prev = block->prev;
+  }
+
+  if (!free_lists[order])
+  {
+    free_lists_bitmap &= ~(1U << order);
+  }
+
+  frame_map[frame] = order;
+}
+
+static int order_for_frames(uint32_t frames)
+{
+  int order = 0;
+  while ((1U << order) < frames)
+  {
+    order++;
+  }
 
-#define MEMORY_SIZE (1024 * 1024 * 1024) // Total memory size (1GB)
-#define BLOCK_SIZE (4 * 1024)            // Size of each memory block (4KB)
-#define BITMAP_SIZE (MEMORY_SIZE / BLOCK_SIZE)
+  return order;
+}
 
-uint8_t *memory; // The actual memory
-uint8_t *bitmap; // The bitmap
+static uint8_t cmos_read(uint8_t reg)
+{
+  write_byte(BLKM_CMOS_ADDRESS_PORT, reg);
+  return read_byte(BLKM_CMOS_DATA_PORT);
+}
+
+// The end of the installed memory as the BIOS reported it, it counts up to 4GB
+uint32_t mem_installed_end()
+{
+  uint64_t blocks = cmos_read(BLKM_CMOS_HIGH_MEMORY_LOW) | (cmos_read(BLKM_CMOS_HIGH_MEMORY_HIGH) << 8);
+  uint64_t end = BLKM_HIGH_MEMORY_START + blocks * 64 * K;
+  return end > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)end;
+}
 
 // Initialize the memory manager
-void mem_init(uint8_t *mem_start, uint8_t *bitmap_start)
+void mem_init(uint8_t *mem_start, size_t size)
 {
   memory = mem_start;
-  bitmap = bitmap_start;
-  memset(bitmap, 0, BITMAP_SIZE / 8); // Clear the bitmap
+  total_frames = size / BLKM_FRAME_SIZE;
+  if (total_frames > BLKM_TOTAL_FRAMES)
+  {
+    total_frames = BLKM_TOTAL_FRAMES;
+  }
+
+  free_frames = 0;
+  free_lists_bitmap = 0;
+  memset(free_lists, 0, sizeof(free_lists));
+  memset(frame_map, 0, sizeof(frame_map));
+
+  // Carve the region into the largest naturally aligned blocks that fit
+  uint32_t frame = 0;
+  while (frame < total_frames)
+  {
+    int order = BLKM_MAX_ORDER;
+    while ((frame & ((1U << order) - 1)) || frame + (1U << order) > total_frames)
+    {
+      order--;
+    }
+
+    free_list_push(frame, order);
+    free_frames += (1U << order);
+    frame += (1U << order);
+  }
 }
 
 // Allocate a block of memory
 void *mem_alloc(size_t size)
 {
-  uint32_t blocks_needed = (size + BLOCK_SIZE - 1) / BLOCK_SIZE; // Round up to nearest block
-  uint32_t blocks_found = 0;
-  uint32_t start_block = 0;
-
-  for (uint32_t i = 0; i < BITMAP_SIZE; i++)
-  {
-    if ((bitmap[i / 8] & (1 << (i % 8))) == 0)
-    { // If the bit is clear
-      if (blocks_found == 0)
-      {
-        start_block = i; // Start of a new free block sequence
-      }
-      blocks_found++;
-      if (blocks_found == blocks_needed)
-      { // If we've found enough blocks
-        // Check alignment
-        if (start_block % blocks_needed == 0)
-        {
-          // Mark the blocks as in use
-          for (uint32_t j = start_block; j < start_block + blocks_needed; j++)
-          {
-            bitmap[j / 8] |= (1 << (j % 8));
-          }
-          return &memory[start_block * BLOCK_SIZE]; // Return the memory block
-        }
-        else
-        {
-          // Reset blocks_found to search for a new sequence
-          blocks_found = 0;
-        }
-      }
-    }
-    else
-    {
-      blocks_found = 0; // Reset the count
-    }
+  if (size == 0)
+  {
+    return 0;
   }
-  return 0; // No free blocks large enough
+
+  uint32_t frames_needed = (size + BLKM_FRAME_SIZE - 1) / BLKM_FRAME_SIZE;
+  int order = order_for_frames(frames_needed);
+  if (order > BLKM_MAX_ORDER)
+  {
+    return 0;
+  }
+
+  // Smallest order with a free block that can hold the request
+  uint32_t candidates = free_lists_bitmap & ~((1U << order) - 1);
+  if (!candidates)
+  {
+    return 0;
+  }
+
+  int current_order = __builtin_ctz(candidates);
+  uint32_t frame = block_to_frame(free_lists[current_order]);
+  free_list_remove(frame, current_order);
+
+  // Split it down, handing the upper halves back to the free lists
+  while (current_order > order)
+  {
+    current_order--;
+    free_list_push(frame + (1U << current_order), current_order);
+  }
+
+  frame_map[frame] = order;
+  free_frames -= (1U << order);
+  return frame_to_block(frame);
 }
 
 // Free a block of memory
-void mem_free(void *ptr, size_t size)
+void mem_free(void *ptr)
 {
-  uint32_t blocks_to_free = (size + BLOCK_SIZE - 1) / BLOCK_SIZE; // Round up to nearest block
-  uint32_t start_block = ((uint8_t *)ptr - memory) / BLOCK_SIZE;
-  // Clear the bits
-  for (uint32_t i = start_block; i < start_block + blocks_to_free; i++)
+  if (!ptr || (uint8_t *)ptr < memory)
+  {
+    return;
+  }
+
+  uint32_t frame = block_to_frame(ptr);
+  if (frame >= total_frames || (frame_map[frame] & BLKM_FRAME_FREE))
   {
-    bitmap[i / 8] &= ~(1 << (i % 8));
+    return;
   }
+
+  int order = frame_map[frame] & BLKM_FRAME_ORDER_MASK;
+  free_frames += (1U << order);
+
+  // Merge with the buddy for as long as it is free and of the same order
+  while (order < BLKM_MAX_ORDER)
+  {
+    uint32_t buddy = frame ^ (1U << order);
+    if (buddy >= total_frames || frame_map[buddy] != (BLKM_FRAME_FREE | order))
+    {
+      break;
+    }
+
+    free_list_remove(buddy, order);
+    frame_map[buddy] = 0;
+    frame_map[frame] = 0;
+    frame = frame < buddy ? frame : buddy;
+    order++;
+  }
+
+  free_list_push(frame, order);
 }
 
 void *mem_zalloc(size_t size)
@@ -81,4 +204,18 @@ void *mem_zalloc(size_t size)
 
   memset(ptr, 0x00, size);
   return ptr;
-}
\ No newline at end of file
+}
+
+void mem_stats(struct blkm_stats_t *stats)
+{
+  memset(stats, 0, sizeof(struct blkm_stats_t));
+  stats->total_frames = total_frames;
+  stats->free_frames = free_frames;
+  for (int order = 0; order < BLKM_TOTAL_ORDERS; order++)
+  {
+    for (struct blkm_free_block_t *block = free_lists[order]; block; block = block->next)
+    {
+      stats->free_blocks[order]++;
+    }
+  }
+}
@@ -3,9 +3,44 @@
 #include <stdint.h>
 #include <stddef.h>
 
-void mem_init(uint8_t *mem_start, uint8_t *bitmap_start);
+#define BLKM_FRAME_SIZE 4096
+
+// Largest block is 2^BLKM_MAX_ORDER frames (64MB)
+#define BLKM_MAX_ORDER 14
+#define BLKM_TOTAL_ORDERS (BLKM_MAX_ORDER + 1)
+
+// Set in the frame map on the first frame of every free block
+#define BLKM_FRAME_FREE 0x80
+#define BLKM_FRAME_ORDER_MASK 0x1F
+
+// Free blocks are linked through their own first frame
+struct blkm_free_block_t
+{
+  struct blkm_free_block_t *next;
+  struct blkm_free_block_t *prev;
+};
+
+struct blkm_stats_t
+{
+  uint32_t total_frames;
+  uint32_t free_frames;
+
+  // Free blocks available at every order
+  uint32_t free_blocks[BLKM_TOTAL_ORDERS];
+};
+
+// The BIOS stores the memory above 16MB in 64KB blocks in these CMOS registers
+#define BLKM_CMOS_ADDRESS_PORT 0x70
+#define BLKM_CMOS_DATA_PORT 0x71
+#define BLKM_CMOS_HIGH_MEMORY_LOW 0x34
+#define BLKM_CMOS_HIGH_MEMORY_HIGH 0x35
+#define BLKM_HIGH_MEMORY_START 0x01000000
+
+uint32_t mem_installed_end();
+void mem_init(uint8_t *mem_start, size_t size);
 void *mem_alloc(size_t size);
 void *mem_zalloc(size_t size);
-void mem_free(void *ptr, size_t size);
+void mem_free(void *ptr);
+void mem_stats(struct blkm_stats_t *stats);
 
 #endif // BLKM_H
@@ -25,6 +25,99 @@ static bool heap_validate_alignment(void *ptr)
   return ((unsigned int)ptr % HEAP_BLOCK_SIZE) == 0;
 }
 
+static int heap_get_entry_type(HEAP_BLOCK_TABLE_ENTRY entry)
+{
+  return entry & 0x0f;
+}
+
+static bool heap_is_block_free(struct heap_t *heap, int block)
+{
+  return heap_get_entry_type(heap->table->entries[block]) == HEAP_BLOCK_TABLE_ENTRY_FREE;
+}
+
+void *heap_block_to_address(struct heap_t *heap, int block)
+{
+  return heap->start_address + (block * HEAP_BLOCK_SIZE);
+}
+
+static struct heap_free_extent_t *heap_free_extent(struct heap_t *heap, int block)
+{
+  return (struct heap_free_extent_t *)heap_block_to_address(heap, block);
+}
+
+// The last block of a free extent points back at the first one so frees can coalesce to the left
+static int *heap_free_extent_footer(struct heap_t *heap, int start_block, uint32_t total_blocks)
+{
+  void *last_block = heap_block_to_address(heap, start_block + total_blocks - 1);
+  return (int *)(last_block + HEAP_BLOCK_SIZE - sizeof(int));
+}
+
+static int heap_free_bucket(uint32_t total_blocks)
+{
+  return 31 - __builtin_clz(total_blocks);
+}
+
+static void heap_free_index_insert(struct heap_t *heap, int start_block, uint32_t total_blocks)
+{
+  struct heap_free_index_t *index = &heap->free_index;
+  int bucket = heap_free_bucket(total_blocks);
+
+  struct heap_free_extent_t *extent = heap_free_extent(heap, start_block);
+  extent->total_blocks = total_blocks;
+  extent->prev = HEAP_FREE_EXTENT_NONE;
+  extent->next = index->buckets[bucket];
+  if (extent->next != HEAP_FREE_EXTENT_NONE)
+  {
+    heap_free_extent(heap, extent->next)->prev = start_block;
+  }
+
+  *heap_free_extent_footer(heap, start_block, total_blocks) = start_block;
+
+  index->buckets[bucket] = start_block;
+  index->bitmap |= (1U << bucket);
+}
+
+static void heap_free_index_remove(struct heap_t *heap, int start_block)
+{
+  struct heap_free_index_t *index = &heap->free_index;
+  struct heap_free_extent_t *extent = heap_free_extent(heap, start_block);
+  int bucket = heap_free_bucket(extent->total_blocks);
+
+  if (extent->prev != HEAP_FREE_EXTENT_NONE)
+  {
+    heap_free_extent(heap, extent->prev)->next = extent->next;
+  }
+  else
+  {
+    index->buckets[bucket] = extent->next;
+  }
+
+  if (extent->next != HEAP_FREE_EXTENT_NONE)
+  {
+    heap_free_extent(heap, extent->next)->prev = extent->prev;
+  }
+
+  if (index->buckets[bucket] == HEAP_FREE_EXTENT_NONE)
+  {
+    index->bitmap &= ~(1U << bucket);
+  }
+}
+
+static void heap_free_index_init(struct heap_t *heap)
+{
+  struct heap_free_index_t *index = &heap->free_index;
+  index->bitmap = 0;
+  for (int i = 0; i < HEAP_FREE_BUCKETS; i++)
+  {
+    index->buckets[i] = HEAP_FREE_EXTENT_NONE;
+  }
+
+  if (heap->table->total > 0)
+  {
+    heap_free_index_insert(heap, 0, heap->table->total);
+  }
+}
+
 int heap_create(struct heap_t *heap, void *ptr, void *end, struct heap_table_t *table)
 {
   int res = 0;
@@ -48,6 +141,8 @@ int heap_create(struct heap_t *heap, void *ptr, void *end, struct heap_table_t *
   size_t table_size = sizeof(HEAP_BLOCK_TABLE_ENTRY) * table->total;
   memset(table->entries, HEAP_BLOCK_TABLE_ENTRY_FREE, table_size);
 
+  heap_free_index_init(heap);
+
 out:
   return res;
 }
@@ -64,54 +159,30 @@ static uint32_t heap_align_value_to_upper(uint32_t val)
   return val;
 }
 
-static int heap_get_entry_type(HEAP_BLOCK_TABLE_ENTRY entry)
-{
-  return entry & 0x0f;
-}
-
 int heap_get_start_block(struct heap_t *heap, uint32_t total_blocks)
 {
-  struct heap_table_t *table = heap->table;
-  int window_size = 0;
-  int window_start = -1;
-
-  for (size_t i = 0; i < table->total; i++)
+  struct heap_free_index_t *index = &heap->free_index;
+  int bucket = heap_free_bucket(total_blocks);
+
+  // Every extent in a bucket above the request's own is guaranteed to fit,
+  // an exact power of two also fits anything in its own bucket
+  int fit_bucket = (total_blocks & (total_blocks - 1)) ? bucket + 1 : bucket;
+  uint32_t candidates = fit_bucket < HEAP_FREE_BUCKETS ? index->bitmap & ~((1U << fit_bucket) - 1) : 0;
+  if (candidates)
   {
-    if (heap_get_entry_type(table->entries[i]) != HEAP_BLOCK_TABLE_ENTRY_FREE)
-    {
-      // Reset the window when encountering a used block
-      window_size = 0;
-      window_start = -1;
-    }
-    else
-    {
-      // Expand the window when encountering a free block
-      if (window_start == -1)
-      {
-        window_start = i;
-      }
-      window_size++;
-
-      // Stop when the window size reaches the required number of blocks
-      if (window_size == total_blocks)
-      {
-        break;
-      }
-    }
+    return index->buckets[__builtin_ctz(candidates)];
   }
 
-  // Return an error if no suitable window was found
-  if (window_start == -1)
+  // Fall back to a first fit walk of the request's own bucket
+  for (int block = index->buckets[bucket]; block != HEAP_FREE_EXTENT_NONE; block = heap_free_extent(heap, block)->next)
   {
-    return -ENOMEM;
+    if (heap_free_extent(heap, block)->total_blocks >= total_blocks)
+    {
+      return block;
+    }
   }
 
-  return window_start;
-}
-
-void *heap_block_to_address(struct heap_t *heap, int block)
-{
-  return heap->start_address + (block * HEAP_BLOCK_SIZE);
+  return -ENOMEM;
 }
 
 void heap_mark_blocks_taken(struct heap_t *heap, int start_block, int total_blocks)
@@ -139,12 +210,25 @@ void *heap_malloc_blocks(struct heap_t *heap, uint32_t total_blocks)
 {
   void *address = 0;
 
+  if (total_blocks == 0)
+  {
+    goto out;
+  }
+
   int start_block = heap_get_start_block(heap, total_blocks);
   if (start_block < 0)
   {
     goto out;
   }
 
+  // Take the extent out of the index and return whatever we do not need
+  uint32_t extent_blocks = heap_free_extent(heap, start_block)->total_blocks;
+  heap_free_index_remove(heap, start_block);
+  if (extent_blocks > total_blocks)
+  {
+    heap_free_index_insert(heap, start_block + total_blocks, extent_blocks - total_blocks);
+  }
+
   address = heap_block_to_address(heap, start_block);
 
   // Mark the blocks as taken
@@ -154,18 +238,23 @@ out:
   return address;
 }
 
-void heap_mark_blocks_free(struct heap_t *heap, int starting_block)
+// Returns the total amount of blocks that were freed
+int heap_mark_blocks_free(struct heap_t *heap, int starting_block)
 {
   struct heap_table_t *table = heap->table;
-  for (int i = starting_block; i < (int)table->total; i++)
+  int i;
+  for (i = starting_block; i < (int)table->total; i++)
   {
     HEAP_BLOCK_TABLE_ENTRY entry = table->entries[i];
     table->entries[i] = HEAP_BLOCK_TABLE_ENTRY_FREE;
     if (!(entry & HEAP_BLOCK_HAS_NEXT))
     {
+      i++;
       break;
     }
   }
+
+  return i - starting_block;
 }
 
 int heap_address_to_block(struct heap_t *heap, void *address)
@@ -182,5 +271,29 @@ void *heap_malloc(struct heap_t *heap, size_t size)
 
 void heap_free(struct heap_t *heap, void *ptr)
 {
-  heap_mark_blocks_free(heap, heap_address_to_block(heap, ptr));
-}
\ No newline at end of file
+  int start_block = heap_address_to_block(heap, ptr);
+  if (start_block < 0 || start_block >= (int)heap->table->total || heap_is_block_free(heap, start_block))
+  {
+    return;
+  }
+
+  uint32_t total_blocks = heap_mark_blocks_free(heap, start_block);
+
+  // Coalesce with the free extents on either side before indexing
+  if (start_block > 0 && heap_is_block_free(heap, start_block - 1))
+  {
+    int left_block = *(int *)(heap_block_to_address(heap, start_block) - sizeof(int));
+    total_blocks += heap_free_extent(heap, left_block)->total_blocks;
+    heap_free_index_remove(heap, left_block);
+    start_block = left_block;
+  }
+
+  int right_block = start_block + total_blocks;
+  if (right_block < (int)heap->table->total && heap_is_block_free(heap, right_block))
+  {
+    total_blocks += heap_free_extent(heap, right_block)->total_blocks;
+    heap_free_index_remove(heap, right_block);
+  }
+
+  heap_free_index_insert(heap, start_block, total_blocks);
+}
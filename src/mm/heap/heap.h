@@ -12,16 +12,40 @@
 
 typedef uint8_t HEAP_BLOCK_TABLE_ENTRY;
 
+// One bucket per power of two, bucket n holds free extents of [2^n, 2^(n+1)) blocks
+#define HEAP_FREE_BUCKETS 32
+#define HEAP_FREE_EXTENT_NONE -1
+
 struct heap_table_t
 {
   HEAP_BLOCK_TABLE_ENTRY *entries;
   size_t total;
 };
 
+// Header written into the first block of every free extent
+struct heap_free_extent_t
+{
+  uint32_t total_blocks;
+  int next;
+  int prev;
+};
+
+// Size bucketed index of the free extents of a heap
+struct heap_free_index_t
+{
+  // Bit n is set when bucket n holds at least one extent
+  uint32_t bitmap;
+
+  // Starting block of the first extent in each bucket
+  int buckets[HEAP_FREE_BUCKETS];
+};
+
 struct heap_t
 {
   struct heap_table_t *table;
 
+  struct heap_free_index_t free_index;
+
   // Start address of the heap data pool
   void *start_address;
 };
@@ -3,10 +3,30 @@
 #include "common/system.h"
 #include "kernel/kernel.h"
 #include "mm/memory.h"
+#include "mm/slab/slab.h"
 
 struct heap_t kernel_heap;
 struct heap_table_t kernel_heap_table;
 
+// Size class caches, index 0 holds the smallest class
+static struct kmem_cache_t *kernel_heap_classes[KERNEL_HEAP_TOTAL_CLASSES];
+
+static void kernel_heap_classes_init()
+{
+  static const char *names[KERNEL_HEAP_TOTAL_CLASSES] = {
+      "kmalloc-8", "kmalloc-16", "kmalloc-32", "kmalloc-64",
+      "kmalloc-128", "kmalloc-256", "kmalloc-512", "kmalloc-1024"};
+
+  for (int i = 0; i < KERNEL_HEAP_TOTAL_CLASSES; i++)
+  {
+    kernel_heap_classes[i] = kmem_cache_create(names[i], 1 << (i + KERNEL_HEAP_MIN_CLASS_SHIFT), 0);
+    if (!kernel_heap_classes[i])
+    {
+      PANIC("Failed to create the kernel heap size classes\n");
+    }
+  }
+}
+
 void kernel_heap_init()
 {
   int total_table_entries = HEAP_SIZE_BYTES / HEAP_BLOCK_SIZE;
@@ -19,10 +39,34 @@ void kernel_heap_init()
   {
     PANIC("Failed to create heap\n");
   }
+
+  kmem_cache_init();
+  kernel_heap_classes_init();
+}
+
+static struct kmem_cache_t *kernel_heap_class_for(size_t size)
+{
+  int index = 0;
+  while ((1U << (index + KERNEL_HEAP_MIN_CLASS_SHIFT)) < size)
+  {
+    index++;
+  }
+
+  return kernel_heap_classes[index];
 }
 
 void *kernel_malloc(size_t size)
 {
+  if (size > 0 && size <= KERNEL_HEAP_MAX_CLASS_SIZE)
+  {
+    struct kmem_cache_t *cache = kernel_heap_class_for(size);
+    // The classes are not usable until the slab layer is up
+    if (cache)
+    {
+      return kmem_cache_alloc(cache);
+    }
+  }
+
   return heap_malloc(&kernel_heap, size);
 }
 
@@ -36,7 +80,54 @@ void *kernel_zalloc(size_t size)
   return ptr;
 }
 
+void *kernel_malloc_pages(size_t size)
+{
+  return heap_malloc(&kernel_heap, size);
+}
+
+void *kernel_zalloc_pages(size_t size)
+{
+  void *ptr = kernel_malloc_pages(size);
+  if (!ptr)
+    return 0;
+
+  memset(ptr, 0x00, size);
+  return ptr;
+}
+
 void kernel_free(void *ptr)
 {
+  if (!ptr)
+  {
+    return;
+  }
+
+  // Heap blocks are always block aligned, slab objects never are
+  if ((uint32_t)ptr % HEAP_BLOCK_SIZE)
+  {
+    kmem_cache_free(kmem_cache_of(ptr), ptr);
+    return;
+  }
+
   heap_free(&kernel_heap, ptr);
-}
\ No newline at end of file
+}
+
+int kernel_heap_class_stats(int class_index, struct kernel_heap_class_stats_t *stats)
+{
+  if (class_index < 0 || class_index >= KERNEL_HEAP_TOTAL_CLASSES)
+  {
+    return -EINVARG;
+  }
+
+  struct kmem_cache_t *cache = kernel_heap_classes[class_index];
+  if (!cache)
+  {
+    return -EINVARG;
+  }
+
+  stats->object_size = cache->object_size;
+  stats->active_objects = cache->active_objects;
+  stats->total_slabs = cache->total_slabs;
+  stats->total_objects = cache->total_slabs * cache->objects_per_slab;
+  return 0;
+}
@@ -4,9 +4,33 @@
 #include <stdint.h>
 #include <stddef.h>
 
+// Requests up to 1 KB are served from power of two size classes carved out of heap blocks
+#define KERNEL_HEAP_MIN_CLASS_SHIFT 3
+#define KERNEL_HEAP_MAX_CLASS_SHIFT 10
+#define KERNEL_HEAP_TOTAL_CLASSES (KERNEL_HEAP_MAX_CLASS_SHIFT - KERNEL_HEAP_MIN_CLASS_SHIFT + 1)
+#define KERNEL_HEAP_MAX_CLASS_SIZE (1 << KERNEL_HEAP_MAX_CLASS_SHIFT)
+
+struct kernel_heap_class_stats_t
+{
+  size_t object_size;
+
+  // Objects currently handed out
+  uint32_t active_objects;
+
+  // Objects that fit in all the slabs the class owns
+  uint32_t total_objects;
+  uint32_t total_slabs;
+};
+
 void kernel_heap_init();
 void *kernel_malloc(size_t size);
 void *kernel_zalloc(size_t size);
+
+// Whole, page aligned heap blocks for memory that gets mapped into tasks
+void *kernel_malloc_pages(size_t size);
+void *kernel_zalloc_pages(size_t size);
+
 void kernel_free(void *ptr);
+int kernel_heap_class_stats(int class_index, struct kernel_heap_class_stats_t *stats);
 
-#endif
\ No newline at end of file
+#endif
@@ -4,6 +4,13 @@ section .asm
 
 global load_page_directory
 global enable_paging
+global cpu_has_pse
+global enable_pse
+global cpu_has_pge
+global enable_pge
+global invalidate_page
+global flush_tlb
+global flush_tlb_global
 
 load_page_directory:
     push ebp
@@ -20,4 +27,83 @@ enable_paging:
     or eax, 0x80000000
     mov cr0, eax
     pop ebp
-    ret
\ No newline at end of file
+    ret
+
+cpu_has_pse:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, 1
+    cpuid
+    mov eax, edx
+    shr eax, 3
+    and eax, 1
+    pop ebx
+    pop ebp
+    ret
+
+enable_pse:
+    push ebp
+    mov ebp, esp
+    mov eax, cr4
+    or eax, 0x10
+    mov cr4, eax
+    pop ebp
+    ret
+
+cpu_has_pge:
+    push ebp
+    mov ebp, esp
+    push ebx
+    mov eax, 1
+    cpuid
+    mov eax, edx
+    shr eax, 13
+    and eax, 1
+    pop ebx
+    pop ebp
+    ret
+
+enable_pge:
+    push ebp
+    mov ebp, esp
+    mov eax, cr4
+    or eax, 0x80
+    mov cr4, eax
+    pop ebp
+    ret
+
+invalidate_page:
+    push ebp
+    mov ebp, esp
+    mov eax, [ebp+8]
+    invlpg [eax]
+    pop ebp
+    ret
+
+flush_tlb:
+    push ebp
+    mov ebp, esp
+    mov eax, cr3
+    mov cr3, eax
+    pop ebp
+    ret
+
+; Toggling CR4.PGE drops every translation, the global ones included
+flush_tlb_global:
+    push ebp
+    mov ebp, esp
+    mov eax, cr4
+    test eax, 0x80
+    jz .reload
+    and eax, ~0x80
+    mov cr4, eax
+    or eax, 0x80
+    mov cr4, eax
+    pop ebp
+    ret
+.reload:
+    mov eax, cr3
+    mov cr3, eax
+    pop ebp
+    ret
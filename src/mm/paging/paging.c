@@ -1,56 +1,172 @@
 #include "idt/idt.h"
 #include "paging.h"
 #include "mm/heap/kernel_heap.h"
+#include "mm/blkm/blkm.h"
+#include "mm/memory.h"
 #include "common/system.h"
 
 // Load the page directory into the processor's control registers (external assembly function)
 extern void load_page_directory(uint32_t *directory);
 
+// Query and enable page size extensions (external assembly functions)
+extern int cpu_has_pse();
+extern void enable_pse();
+extern int cpu_has_pge();
+extern void enable_pge();
+
+// TLB maintenance (external assembly functions)
+extern void invalidate_page(void *virtual_addr);
+extern void flush_tlb();
+extern void flush_tlb_global();
+
+// Whether the kernel identity map is built from 4MB pages
+static bool paging_large_pages = false;
+
+// Whether the kernel identity map may use global pages
+static bool paging_global_pages = false;
+
 // Global variable to store the current page directory
 static uint32_t *current_page_directory = 0;
 
-// Allocate and initialize a new 4GB paging chunk with the specified flags
-struct paging_4GB_chunk_t *paging_new_4GB(uint8_t flags)
+// The kernel chunk whose page tables are linked into every other chunk
+static struct paging_4GB_chunk_t *kernel_chunk = 0;
+
+// Turn on 4MB pages for the kernel identity map if the processor supports them
+void paging_enable_large_pages()
 {
-  // Allocate memory for the page directory
-  uint32_t *directory = kernel_zalloc(sizeof(uint32_t) * PAGING_TOTAL_ENTRIES_PER_TABLE);
+#if PAGING_KERNEL_LARGE_PAGES
+  if (cpu_has_pse())
+  {
+    enable_pse();
+    paging_large_pages = true;
+  }
+#endif
+}
+
+// Turn on global pages for the parts of the kernel identity map no task ever maps over
+void paging_enable_global_pages()
+{
+  if (cpu_has_pge())
+  {
+    enable_pge();
+    paging_global_pages = true;
+  }
+}
 
-  // Initialize offset variable
-  int offset = 0;
+// Global translations must be identical in every directory. Task programs, stacks and
+// process allocations all land below the end of the heap, so only the memory above it qualifies
+static bool paging_is_global_region(uint32_t address)
+{
+  return paging_global_pages && address >= HEAP_ADDRESS + HEAP_SIZE_BYTES && address < PAGING_IDENTITY_MAP_END;
+}
 
-  // Loop through each entry in the page directory
-  for (int i = 0; i < PAGING_TOTAL_ENTRIES_PER_TABLE; i++)
+static uint32_t paging_identity_region_flags(uint32_t region_start)
+{
+  if (paging_is_global_region(region_start))
   {
-    // Allocate memory for a page table entry
-    uint32_t *entry = kernel_zalloc(sizeof(uint32_t) * PAGING_TOTAL_ENTRIES_PER_TABLE);
+    return PAGING_IS_GLOBAL;
+  }
 
-    // Loop through each entry in the page table
-    for (int b = 0; b < PAGING_TOTAL_ENTRIES_PER_TABLE; b++)
+  return 0;
+}
+
+// The identity map is kernel memory, ring 3 only ever reaches the pages mapped for it one by one.
+// Every directory maps it with the same flags, so the global parts translate the same everywhere
+static int paging_identity_map_kernel(struct paging_4GB_chunk_t *chunk)
+{
+  int res = 0;
+  uint32_t flags = PAGING_KERNEL_IDENTITY_FLAGS;
+
+#if PAGING_SHARED_KERNEL_TABLES
+  if (kernel_chunk)
+  {
+    // Link the kernel's supervisor only entries in by reference, paging_set gives the task a private copy when it maps over them
+    for (int i = 0; i < PAGING_IDENTITY_MAP_END / PAGING_LARGE_PAGE_SIZE; i++)
+    {
+      chunk->directory_entry[i] = kernel_chunk->directory_entry[i] | PAGING_DIRECTORY_SHARED;
+    }
+    return 0;
+  }
+#endif
+
+  if (paging_large_pages)
+  {
+    // One directory entry per 4MB, paging_set splits them into page tables where finer mappings are needed
+    for (uint32_t i = 0; i < PAGING_IDENTITY_MAP_END / PAGING_LARGE_PAGE_SIZE; i++)
+    {
+      uint32_t region = i * PAGING_LARGE_PAGE_SIZE;
+      chunk->directory_entry[i] = region | flags | PAGING_IS_LARGE_PAGE | paging_identity_region_flags(region);
+    }
+    return 0;
+  }
+
+  for (uint32_t region = 0; region < PAGING_IDENTITY_MAP_END; region += PAGING_LARGE_PAGE_SIZE)
+  {
+    res = paging_map_range(chunk, (void *)region, (void *)region, PAGING_TOTAL_ENTRIES_PER_TABLE, flags | paging_identity_region_flags(region));
+    if (res < 0)
     {
-      // Calculate the physical address and set it in the page table entry
-      entry[b] = (offset + (b * PAGING_PAGE_SIZE)) | flags;
+      break;
     }
+  }
 
-    // Update the offset
-    offset += (PAGING_TOTAL_ENTRIES_PER_TABLE * PAGING_PAGE_SIZE);
+  return res;
+}
 
-    // Set the page table entry in the page directory
-    directory[i] = (uint32_t)entry | flags | PAGING_IS_WRITEABLE;
+// Allocate and initialize a new 4GB paging chunk
+// The directory starts out empty, page tables are only allocated once something is mapped in their 4MB region
+struct paging_4GB_chunk_t *paging_new_4GB()
+{
+  // Allocate memory for the page directory
+  uint32_t *directory = mem_zalloc(sizeof(uint32_t) * PAGING_TOTAL_ENTRIES_PER_TABLE);
+  if (!directory)
+  {
+    return 0;
   }
 
   // Allocate memory for the paging 4GB chunk structure
   struct paging_4GB_chunk_t *chunk_4GB = kernel_zalloc(sizeof(struct paging_4GB_chunk_t));
+  if (!chunk_4GB)
+  {
+    mem_free(directory);
+    return 0;
+  }
 
   // Set the page directory entry in the paging 4GB chunk structure
   chunk_4GB->directory_entry = directory;
 
+  // Identity map the memory the kernel works with
+  int res = paging_identity_map_kernel(chunk_4GB);
+  if (res < 0)
+  {
+    paging_free_4GB(chunk_4GB);
+    return 0;
+  }
+
   // Return the paging 4GB chunk structure
   return chunk_4GB;
 }
 
+// Allocate the kernel 4GB paging chunk, its page tables are shared with every chunk created afterwards
+struct paging_4GB_chunk_t *paging_new_kernel_4GB()
+{
+  struct paging_4GB_chunk_t *chunk = paging_new_4GB();
+  if (chunk && !kernel_chunk)
+  {
+    kernel_chunk = chunk;
+  }
+
+  return chunk;
+}
+
 // Switch the page directory to the provided 4GB chunk
 void paging_switch(struct paging_4GB_chunk_t *directory)
 {
+  // Reloading CR3 flushes the whole TLB, don't do it for the directory that is already active
+  if (directory->directory_entry == current_page_directory)
+  {
+    return;
+  }
+
   // Load the provided page directory into the processor's control registers
   load_page_directory(directory->directory_entry);
 
@@ -62,20 +178,25 @@ void paging_switch(struct paging_4GB_chunk_t *directory)
 void paging_free_4GB(struct paging_4GB_chunk_t *chunk)
 {
   // Loop through each entry in the page directory
-  for (int i = 0; i < 1024; i++)
+  for (int i = 0; i < PAGING_TOTAL_ENTRIES_PER_TABLE; i++)
   {
     // Get the page directory entry
     uint32_t entry = chunk->directory_entry[i];
+    if (!(entry & PAGING_IS_PRESENT) || (entry & (PAGING_DIRECTORY_SHARED | PAGING_IS_LARGE_PAGE)))
+    {
+      // No page table was ever allocated for this region or it belongs to the kernel
+      continue;
+    }
 
     // Get the page table pointer from the entry
     uint32_t *table = (uint32_t *)(entry & 0xFFFFF000);
 
     // Free the memory occupied by the page table
-    kernel_free(table);
+    mem_free(table);
   }
 
   // Free the memory occupied by the page directory and the paging 4GB chunk structure
-  kernel_free(chunk->directory_entry);
+  mem_free(chunk->directory_entry);
   kernel_free(chunk);
 }
 
@@ -140,8 +261,52 @@ void *paging_align_to_lower_page(void *addr)
   return (void *)_addr;
 }
 
-// Map a virtual address to a physical address in the provided directory with the given flags
-int paging_map(struct paging_4GB_chunk_t *directory, void *virtual_addr, void *physical_addr, int flags)
+// Drop the stale translation of a page changed in the specified directory
+void paging_invalidate(uint32_t *directory, void *virtual_addr)
+{
+  // Inactive directories are flushed by the CR3 load that activates them, global translations are not
+  if (directory != current_page_directory && !paging_is_global_region((uint32_t)virtual_addr))
+  {
+    return;
+  }
+
+  invalidate_page(virtual_addr);
+}
+
+// Drop the stale translations of a range of pages changed in the specified directory
+void paging_invalidate_range(uint32_t *directory, void *virtual_addr, int count)
+{
+  uint32_t start = (uint32_t)virtual_addr;
+  uint32_t end = start + (count * PAGING_PAGE_SIZE);
+  bool global = paging_global_pages && start < PAGING_IDENTITY_MAP_END && end > HEAP_ADDRESS + HEAP_SIZE_BYTES;
+  if (directory != current_page_directory && !global)
+  {
+    return;
+  }
+
+  if (count > PAGING_INVALIDATE_MAX_PAGES)
+  {
+    // A CR3 reload keeps global translations, only toggling PGE drops them
+    if (global)
+    {
+      flush_tlb_global();
+      return;
+    }
+
+    flush_tlb();
+    return;
+  }
+
+  for (int i = 0; i < count; i++)
+  {
+    invalidate_page(virtual_addr + (i * PAGING_PAGE_SIZE));
+  }
+}
+
+static int paging_set_entry(uint32_t *directory, void *virtual_addr, uint32_t val);
+
+// Map a single page without touching the TLB, callers invalidate once they are done
+static int paging_map_page(struct paging_4GB_chunk_t *directory, void *virtual_addr, void *physical_addr, int flags)
 {
   // Check if the virtual and physical addresses are aligned to the page size
   if (((unsigned int)virtual_addr % PAGING_PAGE_SIZE) || ((unsigned int)physical_addr % PAGING_PAGE_SIZE))
@@ -151,27 +316,45 @@ int paging_map(struct paging_4GB_chunk_t *directory, void *virtual_addr, void *p
   }
 
   // Set the virtual address to the specified physical address in the page directory
-  return paging_set(directory->directory_entry, virtual_addr, (uint32_t)physical_addr | flags);
+  return paging_set_entry(directory->directory_entry, virtual_addr, (uint32_t)physical_addr | flags);
+}
+
+// Map a virtual address to a physical address in the provided directory with the given flags
+int paging_map(struct paging_4GB_chunk_t *directory, void *virtual_addr, void *physical_addr, int flags)
+{
+  int res = paging_map_page(directory, virtual_addr, physical_addr, flags);
+  if (res < 0)
+  {
+    return res;
+  }
+
+  paging_invalidate(directory->directory_entry, virtual_addr);
+  return 0;
 }
 
 // Map a range of virtual addresses to physical addresses in the provided directory with the given flags
 int paging_map_range(struct paging_4GB_chunk_t *directory, void *virtual_addr, void *physical_addr, int count, int flags)
 {
   int res = 0;
+  void *start = virtual_addr;
+  int mapped = 0;
 
   // Loop through each page in the range
   for (int i = 0; i < count; i++)
   {
     // Map the virtual address to the physical address with the specified flags
-    res = paging_map(directory, virtual_addr, physical_addr, flags);
+    res = paging_map_page(directory, virtual_addr, physical_addr, flags);
     if (res < 0)
       break;
 
     // Increment the virtual and physical addresses by the page size
     virtual_addr += PAGING_PAGE_SIZE;
     physical_addr += PAGING_PAGE_SIZE;
+    mapped++;
   }
 
+  paging_invalidate_range(directory->directory_entry, start, mapped);
+
   // Return the result
   return res;
 }
@@ -197,19 +380,25 @@ int paging_map_virtual_to_physical_addresses(struct paging_4GB_chunk_t *director
     goto out;
   }
 
+  void *start = virtual_addr;
+  int mapped = 0;
+
   // Loop through each page in the range
   while (physical_addr < physical_end_addr)
   {
     // Map the virtual address to the physical address with the specified flags
-    res = paging_map(directory, virtual_addr, physical_addr, flags);
+    res = paging_map_page(directory, virtual_addr, physical_addr, flags);
     if (res < 0)
       break;
 
     // Increment the virtual and physical addresses by the page size
     virtual_addr += PAGING_PAGE_SIZE;
     physical_addr += PAGING_PAGE_SIZE;
+    mapped++;
   }
 
+  paging_invalidate_range(directory->directory_entry, start, mapped);
+
 out:
   // Return the result
   return res;
@@ -217,6 +406,18 @@ out:
 
 // Set the value of a virtual address in the specified directory to the given value
 int paging_set(uint32_t *directory, void *virtual_addr, uint32_t val)
+{
+  int res = paging_set_entry(directory, virtual_addr, val);
+  if (res < 0)
+  {
+    return res;
+  }
+
+  paging_invalidate(directory, virtual_addr);
+  return 0;
+}
+
+static int paging_set_entry(uint32_t *directory, void *virtual_addr, uint32_t val)
 {
   uint32_t directory_index;
   uint32_t table_index;
@@ -226,6 +427,62 @@ int paging_set(uint32_t *directory, void *virtual_addr, uint32_t val)
   if (res < 0)
     return res;
 
+  // The kernel's global translation would outlive the CR3 load, another directory can never map over it
+  if (kernel_chunk && directory != kernel_chunk->directory_entry && paging_is_global_region((uint32_t)virtual_addr))
+  {
+    return -EINVARG;
+  }
+
+  // Allocate the page table on the first mapping into its region
+  if (!(directory[directory_index] & PAGING_IS_PRESENT))
+  {
+    if (!(val & PAGING_IS_PRESENT))
+    {
+      // Nothing to unmap
+      return 0;
+    }
+
+    uint32_t *new_table = mem_zalloc(sizeof(uint32_t) * PAGING_TOTAL_ENTRIES_PER_TABLE);
+    if (!new_table)
+    {
+      return -ENOMEM;
+    }
+
+    directory[directory_index] = (uint32_t)new_table | PAGING_IS_PRESENT | PAGING_IS_WRITEABLE | PAGING_ACCESS_FROM_ALL;
+  }
+  else if (directory[directory_index] & PAGING_IS_LARGE_PAGE)
+  {
+    // Split the 4MB page into a page table mapping the same memory. The split entries keep the
+    // large page's supervisor only flags, only the entry being set below is granted to ring 3
+    uint32_t *split_table = mem_alloc(sizeof(uint32_t) * PAGING_TOTAL_ENTRIES_PER_TABLE);
+    if (!split_table)
+    {
+      return -ENOMEM;
+    }
+
+    uint32_t large_page = directory[directory_index];
+    uint32_t base = large_page & 0xFFC00000;
+    uint32_t flags = large_page & 0xFFF & ~(PAGING_IS_LARGE_PAGE | PAGING_DIRECTORY_SHARED | PAGING_IS_GLOBAL);
+    for (int i = 0; i < PAGING_TOTAL_ENTRIES_PER_TABLE; i++)
+    {
+      split_table[i] = (base + (i * PAGING_PAGE_SIZE)) | flags;
+    }
+
+    directory[directory_index] = (uint32_t)split_table | PAGING_IS_PRESENT | PAGING_IS_WRITEABLE | PAGING_ACCESS_FROM_ALL;
+  }
+  else if (directory[directory_index] & PAGING_DIRECTORY_SHARED)
+  {
+    // Never write through to the kernel's page table, copy it first
+    uint32_t *private_table = mem_alloc(sizeof(uint32_t) * PAGING_TOTAL_ENTRIES_PER_TABLE);
+    if (!private_table)
+    {
+      return -ENOMEM;
+    }
+
+    memcpy(private_table, (void *)(directory[directory_index] & 0xFFFFF000), sizeof(uint32_t) * PAGING_TOTAL_ENTRIES_PER_TABLE);
+    directory[directory_index] = (uint32_t)private_table | PAGING_IS_PRESENT | PAGING_IS_WRITEABLE | PAGING_ACCESS_FROM_ALL;
+  }
+
   // Get the page table pointer from the directory entry
   uint32_t *table = (uint32_t *)(directory[directory_index] & 0xFFFFF000);
 
@@ -247,6 +504,17 @@ uint32_t paging_get(uint32_t *directory, void *virtual_addr)
   if (res < 0)
     return 0;
 
+  // Regions without a page table are not mapped
+  if (!(directory[directory_index] & PAGING_IS_PRESENT))
+    return 0;
+
+  // Describe the 4KB page of a 4MB page as a page table entry would
+  if (directory[directory_index] & PAGING_IS_LARGE_PAGE)
+  {
+    uint32_t large_page = directory[directory_index];
+    return ((large_page & 0xFFC00000) + (table_index * PAGING_PAGE_SIZE)) | (large_page & 0xFFF & ~(PAGING_IS_LARGE_PAGE | PAGING_DIRECTORY_SHARED));
+  }
+
   // Get the page table pointer from the directory entry
   uint32_t *table = (uint32_t *)(directory[directory_index] & 0xFFFFF000);
 
@@ -260,14 +528,27 @@ void *paging_get_physical_address(uint32_t *directory, void *virtual_addr)
   uint32_t directory_index;
   uint32_t table_index;
 
-  // Get the directory and table indexes for the virtual address
-  int res = paging_get_indexes(virtual_addr, &directory_index, &table_index);
+  // Get the directory and table indexes for the page holding the virtual address
+  int res = paging_get_indexes(paging_align_to_lower_page(virtual_addr), &directory_index, &table_index);
   if (res < 0)
     return NULL;
 
+  // Regions without a page table are not mapped
+  if (!(directory[directory_index] & PAGING_IS_PRESENT))
+    return NULL;
+
+  if (directory[directory_index] & PAGING_IS_LARGE_PAGE)
+  {
+    return (void *)((directory[directory_index] & 0xFFC00000) + ((uint32_t)virtual_addr & 0x003FFFFF));
+  }
+
   // Get the page table pointer from the directory entry
   uint32_t *table = (uint32_t *)(directory[directory_index] & 0xFFFFF000);
 
+  // Pages that are not present have no physical address
+  if (!(table[table_index] & PAGING_IS_PRESENT))
+    return NULL;
+
   // Get the physical address from the page table entry
   uint32_t physical_addr = table[table_index] & 0xFFFFF000;
 
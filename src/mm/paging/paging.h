@@ -11,6 +11,16 @@
 #define PAGING_IS_WRITEABLE 0b00000010    // Writeable flag
 #define PAGING_IS_PRESENT 0b00000001      // Present flag
 
+#define PAGING_IS_LARGE_PAGE 0b10000000 // Directory entry maps a 4MB page directly
+#define PAGING_IS_GLOBAL 0x100           // Translation survives CR3 reloads
+
+#define PAGING_DIRECTORY_SHARED 0x200 // Available bit marking a page table owned by the kernel directory
+#define PAGING_LARGE_PAGE_SIZE (PAGING_TOTAL_ENTRIES_PER_TABLE * PAGING_PAGE_SIZE)
+
+#define PAGING_KERNEL_IDENTITY_FLAGS (PAGING_IS_PRESENT | PAGING_IS_WRITEABLE) // Supervisor only, the same in every directory
+
+#define PAGING_INVALIDATE_MAX_PAGES 32 // Larger ranges flush the whole TLB instead of invlpg per page
+
 #define PAGING_TOTAL_ENTRIES_PER_TABLE 1024 // Total entries per page table
 #define PAGING_PAGE_SIZE 4096               // Page size in bytes
 
@@ -20,8 +30,11 @@ struct paging_4GB_chunk_t
   uint32_t *directory_entry; // Pointer to the page directory entry
 };
 
-// Allocate and initialize a new 4GB paging chunk with the specified flags
-struct paging_4GB_chunk_t *paging_new_4GB(uint8_t flags);
+// Allocate and initialize a new 4GB paging chunk, the kernel memory is identity mapped into it
+struct paging_4GB_chunk_t *paging_new_4GB();
+
+// Allocate the kernel 4GB paging chunk, its page tables are shared with every chunk created afterwards
+struct paging_4GB_chunk_t *paging_new_kernel_4GB();
 
 // Switch the page directory to the provided 4GB chunk
 void paging_switch(struct paging_4GB_chunk_t *directory);
@@ -29,9 +42,19 @@ void paging_switch(struct paging_4GB_chunk_t *directory);
 // Enable paging (external assembly function)
 extern void enable_paging();
 
+// Turn on 4MB pages for the kernel identity map if the processor supports them
+void paging_enable_large_pages();
+
+// Turn on global pages for the parts of the kernel identity map no task ever maps over
+void paging_enable_global_pages();
+
 // Set the value of a virtual address in the specified directory to the given value
 int paging_set(uint32_t *directory, void *virtual_addr, uint32_t val);
 
+// Drop stale translations of a page or a range of pages changed in the specified directory
+void paging_invalidate(uint32_t *directory, void *virtual_addr);
+void paging_invalidate_range(uint32_t *directory, void *virtual_addr, int count);
+
 // Check if a given address is aligned to the page size
 bool paging_is_aligned(void *addr);
 
@@ -0,0 +1,247 @@
+#include "slab.h"
+#include "mm/blkm/blkm.h"
+#include "mm/memory.h"
+#include "string/string.h"
+#include "common/system.h"
+#include <stdbool.h>
+
+// The cache of cache descriptors, set up statically so kmem_cache_create can use it
+static struct kmem_cache_t kmem_cache_cache;
+
+// All the caches in the system
+static struct kmem_cache_t *kmem_cache_list = 0;
+
+static size_t kmem_cache_slab_header_size()
+{
+  return ALIGN(sizeof(struct slab_t), SLAB_OBJECT_ALIGN);
+}
+
+static int kmem_cache_setup(struct kmem_cache_t *cache, const char *name, size_t size, KMEM_CACHE_CTOR ctor)
+{
+  // Free objects hold the free list link so they can never be smaller than a pointer
+  if (size < sizeof(void *))
+  {
+    size = sizeof(void *);
+  }
+
+  size = ALIGN(size, SLAB_OBJECT_ALIGN);
+  if (size > SLAB_SIZE - kmem_cache_slab_header_size())
+  {
+    return -EINVARG;
+  }
+
+  memset(cache, 0, sizeof(struct kmem_cache_t));
+  strncpy(cache->name, name, sizeof(cache->name) - 1);
+  cache->object_size = size;
+  cache->objects_per_slab = (SLAB_SIZE - kmem_cache_slab_header_size()) / size;
+  cache->ctor = ctor;
+
+  cache->next = kmem_cache_list;
+  kmem_cache_list = cache;
+  return 0;
+}
+
+void kmem_cache_init()
+{
+  int res = kmem_cache_setup(&kmem_cache_cache, "kmem_cache", sizeof(struct kmem_cache_t), 0);
+  if (res < 0)
+  {
+    PANIC("Failed to create the kmem_cache cache\n");
+  }
+}
+
+struct kmem_cache_t *kmem_cache_create(const char *name, size_t size, KMEM_CACHE_CTOR ctor)
+{
+  struct kmem_cache_t *cache = kmem_cache_alloc(&kmem_cache_cache);
+  if (!cache)
+  {
+    return 0;
+  }
+
+  if (kmem_cache_setup(cache, name, size, ctor) < 0)
+  {
+    kmem_cache_free(&kmem_cache_cache, cache);
+    return 0;
+  }
+
+  return cache;
+}
+
+static void slab_list_insert(struct slab_t **list, struct slab_t *slab)
+{
+  slab->prev = 0;
+  slab->next = *list;
+  if (*list)
+  {
+    (*list)->prev = slab;
+  }
+  *list = slab;
+}
+
+static void slab_list_remove(struct slab_t **list, struct slab_t *slab)
+{
+  if (slab->prev)
+  {
+    slab->prev->next = slab->next;
+  }
+  else
+  {
+    *list = slab->next;
+  }
+
+  if (slab->next)
+  {
+    slab->next->prev = slab->prev;
+  }
+
+  slab->next = 0;
+  slab->prev = 0;
+}
+
+static struct slab_t *slab_new(struct kmem_cache_t *cache)
+{
+  struct slab_t *slab = mem_alloc(SLAB_SIZE);
+  if (!slab)
+  {
+    return 0;
+  }
+
+  slab->cache = cache;
+  slab->next = 0;
+  slab->prev = 0;
+  slab->in_use = 0;
+  slab->free_list = 0;
+
+  // Thread the free list back to front so objects are handed out in address order
+  void *objects = (void *)slab + kmem_cache_slab_header_size();
+  for (int i = cache->objects_per_slab - 1; i >= 0; i--)
+  {
+    void *object = objects + (i * cache->object_size);
+    *(void **)object = slab->free_list;
+    slab->free_list = object;
+  }
+
+  cache->total_slabs++;
+  return slab;
+}
+
+static void slab_destroy(struct slab_t *slab)
+{
+  slab->cache->total_slabs--;
+  mem_free(slab);
+}
+
+static struct slab_t *slab_from_object(void *ptr)
+{
+  return (struct slab_t *)((uint32_t)ptr & ~(SLAB_SIZE - 1));
+}
+
+static void *kmem_cache_take_object(struct kmem_cache_t *cache)
+{
+  struct slab_t *slab = cache->partial;
+  if (!slab)
+  {
+    slab = cache->empty;
+    if (slab)
+    {
+      cache->empty = 0;
+    }
+    else
+    {
+      slab = slab_new(cache);
+      if (!slab)
+      {
+        return 0;
+      }
+    }
+
+    slab_list_insert(&cache->partial, slab);
+  }
+
+  void *object = slab->free_list;
+  slab->free_list = *(void **)object;
+  slab->in_use++;
+  cache->active_objects++;
+
+  if (slab->in_use == cache->objects_per_slab)
+  {
+    slab_list_remove(&cache->partial, slab);
+    slab_list_insert(&cache->full, slab);
+  }
+
+  return object;
+}
+
+void *kmem_cache_alloc(struct kmem_cache_t *cache)
+{
+  void *object = kmem_cache_take_object(cache);
+  if (object && cache->ctor)
+  {
+    cache->ctor(object);
+  }
+
+  return object;
+}
+
+void *kmem_cache_zalloc(struct kmem_cache_t *cache)
+{
+  void *object = kmem_cache_take_object(cache);
+  if (!object)
+  {
+    return 0;
+  }
+
+  memset(object, 0x00, cache->object_size);
+  if (cache->ctor)
+  {
+    cache->ctor(object);
+  }
+
+  return object;
+}
+
+// Returns the cache owning the given slab object
+struct kmem_cache_t *kmem_cache_of(void *ptr)
+{
+  return slab_from_object(ptr)->cache;
+}
+
+void kmem_cache_free(struct kmem_cache_t *cache, void *ptr)
+{
+  if (!ptr)
+  {
+    return;
+  }
+
+  struct slab_t *slab = slab_from_object(ptr);
+  if (slab->cache != cache)
+  {
+    PANIC("kmem_cache_free(): Object does not belong to this cache\n");
+  }
+
+  bool was_full = slab->in_use == cache->objects_per_slab;
+
+  *(void **)ptr = slab->free_list;
+  slab->free_list = ptr;
+  slab->in_use--;
+  cache->active_objects--;
+
+  if (was_full)
+  {
+    slab_list_remove(&cache->full, slab);
+    slab_list_insert(&cache->partial, slab);
+  }
+
+  if (slab->in_use == 0)
+  {
+    slab_list_remove(&cache->partial, slab);
+    if (cache->empty)
+    {
+      slab_destroy(slab);
+    }
+    else
+    {
+      cache->empty = slab;
+    }
+  }
+}
@@ -0,0 +1,63 @@
+#ifndef MEMORY_SLAB_H
+#define MEMORY_SLAB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "common/system.h"
+
+// Every slab is exactly one physical frame, the slab header lives at its start
+#define SLAB_SIZE HEAP_BLOCK_SIZE
+#define SLAB_OBJECT_ALIGN 8
+
+typedef void (*KMEM_CACHE_CTOR)(void *object);
+
+struct kmem_cache_t;
+
+struct slab_t
+{
+  // The cache this slab belongs to
+  struct kmem_cache_t *cache;
+
+  struct slab_t *next;
+  struct slab_t *prev;
+
+  // Singly linked list threaded through the free objects
+  void *free_list;
+
+  // Total objects handed out from this slab
+  uint32_t in_use;
+};
+
+struct kmem_cache_t
+{
+  char name[20];
+
+  // Size of a single object after alignment
+  size_t object_size;
+  uint32_t objects_per_slab;
+
+  // Optional, called on every object before it is handed out
+  KMEM_CACHE_CTOR ctor;
+
+  // Slabs with at least one free and one used object
+  struct slab_t *partial;
+  // Slabs with no free objects left
+  struct slab_t *full;
+  // A single fully free slab kept around to avoid heap churn
+  struct slab_t *empty;
+
+  uint32_t total_slabs;
+  uint32_t active_objects;
+
+  // Next cache in the global cache list
+  struct kmem_cache_t *next;
+};
+
+void kmem_cache_init();
+struct kmem_cache_t *kmem_cache_create(const char *name, size_t size, KMEM_CACHE_CTOR ctor);
+void *kmem_cache_alloc(struct kmem_cache_t *cache);
+void *kmem_cache_zalloc(struct kmem_cache_t *cache);
+void kmem_cache_free(struct kmem_cache_t *cache, void *ptr);
+struct kmem_cache_t *kmem_cache_of(void *ptr);
+
+#endif
@@ -0,0 +1,35 @@
+#include <task/mutex.h>
+#include <task/task.h>
+#include <common/system.h>
+
+void mutex_init(struct mutex_t *mutex)
+{
+  mutex->locked = false;
+  mutex->owner = 0;
+  wait_queue_init(&mutex->waiters);
+}
+
+// Take the lock, sleeping until its owner releases it
+void mutex_lock(struct mutex_t *mutex)
+{
+  while (mutex->locked)
+  {
+    if (!task_can_block() || mutex->owner == task_current())
+    {
+      PANIC("Deadlock on a mutex\n");
+    }
+
+    wait_queue_sleep(&mutex->waiters);
+  }
+
+  mutex->locked = true;
+  mutex->owner = task_current();
+}
+
+// Release the lock, every sleeper retries and the first one scheduled takes it
+void mutex_unlock(struct mutex_t *mutex)
+{
+  mutex->locked = false;
+  mutex->owner = 0;
+  wait_queue_wake_all(&mutex->waiters);
+}
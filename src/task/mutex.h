@@ -0,0 +1,21 @@
+#ifndef MUTEX_H
+#define MUTEX_H
+
+#include <stdbool.h>
+#include <task/waitqueue.h>
+
+struct task_t;
+
+// A lock that puts contending tasks to sleep, for code that blocks while holding it
+struct mutex_t
+{
+  bool locked;
+  struct task_t *owner;
+  struct wait_queue_t waiters;
+};
+
+void mutex_init(struct mutex_t *mutex);
+void mutex_lock(struct mutex_t *mutex);
+void mutex_unlock(struct mutex_t *mutex);
+
+#endif
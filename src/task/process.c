@@ -15,9 +15,13 @@ struct process_t *current_process = 0;
 
 static struct process_t *processes[MAX_PROCESSES] = {};
 
+// Slots held by a load in progress, loading sleeps on the disk so the slot is claimed up front
+static bool process_slots_reserved[MAX_PROCESSES] = {};
+
 static void process_init(struct process_t *process)
 {
   memset(process, 0, sizeof(struct process_t));
+  wait_queue_init(&process->keyboard_waiters);
 }
 
 struct process_t *process_current()
@@ -58,7 +62,7 @@ static int process_find_free_allocation_index(struct process_t *process)
 
 void *process_malloc(struct process_t *process, size_t size)
 {
-  void *ptr = kernel_zalloc(size);
+  void *ptr = kernel_zalloc_pages(size);
   if (!ptr)
   {
     goto out_err;
@@ -283,7 +287,8 @@ void process_free(struct process_t *process, void *ptr)
     return;
   }
 
-  int res = paging_map_virtual_to_physical_addresses(process->task->page_directory, allocation->ptr, allocation->ptr, paging_align_address(allocation->ptr + allocation->size), 0x00);
+  // Hand the pages back to the kernel, they stay mapped since the kernel runs on this directory too
+  int res = paging_map_virtual_to_physical_addresses(process->task->page_directory, allocation->ptr, allocation->ptr, paging_align_address(allocation->ptr + allocation->size), PAGING_IS_PRESENT | PAGING_IS_WRITEABLE);
   if (res < 0)
   {
     return;
@@ -292,6 +297,12 @@ void process_free(struct process_t *process, void *ptr)
   // Unjoin the allocation
   process_allocation_unjoin(process, ptr);
 
+  // The rings are gone once the process frees them
+  if (ptr == process->syscall_ring)
+  {
+    process->syscall_ring = 0;
+  }
+
   // We can now free the memory.
   kernel_free(ptr);
 }
@@ -314,7 +325,7 @@ static int process_load_binary(const char *filename, struct process_t *process)
     goto out;
   }
 
-  program_data_ptr = kernel_zalloc(stat.filesize);
+  program_data_ptr = kernel_zalloc_pages(stat.filesize);
   if (!program_data_ptr)
   {
     res = -ENOMEM;
@@ -436,7 +447,7 @@ int process_get_free_slot()
 {
   for (int i = 0; i < MAX_PROCESSES; i++)
   {
-    if (processes[i] == 0)
+    if (processes[i] == 0 && !process_slots_reserved[i])
       return i;
   }
 
@@ -474,15 +485,16 @@ int process_load_for_slot(const char *filename, struct process_t **process, int
 {
   int res = 0;
   struct task_t *task = 0;
-  struct process_t *_process;
+  struct process_t *_process = 0;
   void *program_stack_ptr = 0;
 
-  if (process_get(process_slot) != 0)
+  if (process_slot < 0 || process_slot >= MAX_PROCESSES || process_get(process_slot) != 0 || process_slots_reserved[process_slot])
   {
-    res = -EISTKN;
-    goto out;
+    return -EISTKN;
   }
 
+  process_slots_reserved[process_slot] = true;
+
   _process = kernel_zalloc(sizeof(struct process_t));
   if (!_process)
   {
@@ -497,7 +509,7 @@ int process_load_for_slot(const char *filename, struct process_t **process, int
     goto out;
   }
 
-  program_stack_ptr = kernel_zalloc(USER_PROGRAM_STACK_SIZE);
+  program_stack_ptr = kernel_zalloc_pages(USER_PROGRAM_STACK_SIZE);
   if (!program_stack_ptr)
   {
     res = -ENOMEM;
@@ -530,6 +542,7 @@ int process_load_for_slot(const char *filename, struct process_t **process, int
   processes[process_slot] = _process;
 
 out:
+  process_slots_reserved[process_slot] = false;
   if (ISERR(res))
   {
     if (_process && _process->task)
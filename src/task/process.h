@@ -5,6 +5,8 @@
 
 #include <task/task.h>
 #include <common/system.h>
+#include <isr80h/isr80h.h>
+#include <task/waitqueue.h>
 
 #define PROCESS_FILETYPE_ELF 0
 #define PROCESS_FILETYPE_BINARY 1
@@ -64,8 +66,19 @@ struct process_t
     int head;
   } keyboard;
 
+  // Tasks sleeping until a key is pushed to this process
+  struct wait_queue_t keyboard_waiters;
+
   // The arguments of the process.
   struct process_arguments_t arguments;
+
+  // The batched syscall rings, allocated on request
+  struct syscall_ring_t *syscall_ring;
+
+#if ISR80H_SYSCALL_STATS
+  // The syscalls made by this process
+  struct isr80h_command_stats_t syscall_stats[ISR80H_STATS_MAX_COMMANDS];
+#endif
 };
 
 int process_switch(struct process_t *process);
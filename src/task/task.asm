@@ -4,6 +4,7 @@ section .asm
 global restore_registers_state_t
 global task_return
 global user_registers
+global task_switch_stack
 
 ; This function is used to return from a task switch.
 ; It takes a pointer to a registers_state_t structure, which contains the saved state of the task.
@@ -63,3 +64,22 @@ user_registers:
     mov fs, ax  ; Set FS to the value in AX
     mov gs, ax  ; Set GS to the value in AX
     ret  ; Return from the function
+
+; This function switches from one kernel stack to another.
+; It takes a pointer to store the current stack pointer in and the stack pointer to resume.
+; It returns on the new stack, and on the old one once something switches back to it.
+task_switch_stack:
+    push ebp  ; Save the callee saved registers on the stack we leave
+    mov ebp, esp
+    mov eax, [ebp+8]  ; Load where the current stack pointer goes
+    mov ecx, [ebp+12]  ; Load the stack pointer to resume
+    push ebx
+    push esi
+    push edi
+    mov [eax], esp  ; Save the current stack pointer
+    mov esp, ecx  ; Switch to the new stack
+    pop edi  ; Restore the callee saved registers it was left with
+    pop esi
+    pop ebx
+    pop ebp
+    ret  ; Return to wherever the new stack switched away, or to its entry function
@@ -3,11 +3,16 @@
 #include <common/system.h>
 #include <task/process.h>
 #include <mm/heap/kernel_heap.h>
+#include <mm/slab/slab.h>
 #include <mm/memory.h>
 #include <string/string.h>
 #include <mm/paging/paging.h>
 #include <idt/idt.h>
 #include <loaders/elf/loader.h>
+#include <task/waitqueue.h>
+#include <io/io.h>
+#include <task/tss.h>
+#include <timer/timer.h>
 
 // The current task that is running
 struct task_t *current_task = 0;
@@ -16,8 +21,123 @@ struct task_t *current_task = 0;
 struct task_t *task_tail = 0;
 struct task_t *task_head = 0;
 
+// Slab cache all the tasks are allocated from
+static struct kmem_cache_t *task_cache = 0;
+
+// Tasks ready to run, one FIFO per priority level
+struct task_run_queue_t
+{
+  struct task_t *head;
+  struct task_t *tail;
+};
+
+static struct task_run_queue_t task_run_queues[TASK_PRIORITY_LEVELS];
+
+// Bit n is set while run queue n is not empty
+static uint32_t task_run_queue_bitmap = 0;
+
+// Clock ticks since the last priority boost
+static int task_boost_ticks = 0;
+
+// The kernel task that runs when every other task is blocked, it never sits in a run queue
+static struct task_t idle_task;
+
+// Time stamps for the idle percentage
+static uint64_t idle_task_start_cycles = 0;
+static uint64_t idle_task_idle_cycles = 0;
+
+// Whether the first task was started, before that the kernel runs on the boot stack
+static bool task_scheduling = false;
+
+// Where the stack pointer of a task that exited is saved, nothing ever resumes it
+static uint32_t task_exited_esp = 0;
+
+// The kernel stack of the task that exited last, freed once we switched off it
+static void *task_exited_stack = 0;
+
 int task_init(struct task_t *task, struct process_t *process);
 
+// Lower priority levels get longer slices, they are CPU bound and switching them often buys nothing
+static int task_time_slice(struct task_t *task)
+{
+  return (task->priority + 1) * TASK_SLICE_TICKS;
+}
+
+static void task_run_queue_add(struct task_t *task)
+{
+  struct task_run_queue_t *queue = &task_run_queues[task->priority];
+  task->run_next = 0;
+  task->run_prev = queue->tail;
+  if (queue->tail)
+  {
+    queue->tail->run_next = task;
+  }
+  else
+  {
+    queue->head = task;
+  }
+
+  queue->tail = task;
+  task->queued = true;
+  task_run_queue_bitmap |= (1 << task->priority);
+}
+
+static void task_run_queue_remove(struct task_t *task)
+{
+  struct task_run_queue_t *queue = &task_run_queues[task->priority];
+  if (task->run_prev)
+  {
+    task->run_prev->run_next = task->run_next;
+  }
+  else
+  {
+    queue->head = task->run_next;
+  }
+
+  if (task->run_next)
+  {
+    task->run_next->run_prev = task->run_prev;
+  }
+  else
+  {
+    queue->tail = task->run_prev;
+  }
+
+  task->run_next = 0;
+  task->run_prev = 0;
+  task->queued = false;
+  if (!queue->head)
+  {
+    task_run_queue_bitmap &= ~(1 << task->priority);
+  }
+}
+
+// Move a task to another level, keeping its run queue consistent
+static void task_set_priority(struct task_t *task, int priority)
+{
+  bool queued = task->queued;
+  if (queued)
+  {
+    task_run_queue_remove(task);
+  }
+
+  task->priority = priority;
+  task->slice_left = task_time_slice(task);
+  if (queued)
+  {
+    task_run_queue_add(task);
+  }
+}
+
+void task_cache_init()
+{
+  task_cache = kmem_cache_create("task", sizeof(struct task_t), 0);
+  if (!task_cache)
+  {
+    PANIC("Failed to create the task cache\n");
+  }
+}
+
 struct task_t *task_current()
 {
   return current_task;
@@ -26,7 +146,7 @@ struct task_t *task_current()
 struct task_t *new_task(struct process_t *process)
 {
   int res = 0;
-  struct task_t *task = kernel_zalloc(sizeof(struct task_t));
+  struct task_t *task = kmem_cache_zalloc(task_cache);
   if (!task)
   {
     res = -ENOMEM;
@@ -39,6 +159,8 @@ struct task_t *new_task(struct process_t *process)
     goto out;
   }
 
+  task_run_queue_add(task);
+
   if (task_head == 0)
   {
     task_head = task;
@@ -61,14 +183,15 @@ out:
   return task;
 }
 
+// Pick the first task of the best non empty run queue, the idle task when no task can run
 struct task_t *task_get_next()
 {
-  if (!current_task->next)
+  if (!task_run_queue_bitmap)
   {
-    return task_head;
+    return idle_task.kernel_stack ? &idle_task : 0;
   }
 
-  return current_task->next;
+  return task_run_queues[__builtin_ctz(task_run_queue_bitmap)].head;
 }
 
 static void task_list_remove(struct task_t *task)
@@ -78,6 +201,11 @@ static void task_list_remove(struct task_t *task)
     task->prev->next = task->next;
   }
 
+  if (task->next)
+  {
+    task->next->prev = task->prev;
+  }
+
   if (task == task_head)
   {
     task_head = task->next;
@@ -88,41 +216,320 @@ static void task_list_remove(struct task_t *task)
     task_tail = task->prev;
   }
 
+  if (task->queued)
+  {
+    task_run_queue_remove(task);
+  }
+
+  wait_queue_remove(task);
+  timer_cancel(&task->sleep_timer);
+
+  // The scheduler picks whoever runs next
   if (task == current_task)
   {
-    current_task = task_get_next();
+    current_task = 0;
+  }
+}
+
+// Free the stack of the task that exited last, it is only safe once we run on another one
+static void task_switch_finish()
+{
+  if (task_exited_stack)
+  {
+    kernel_free(task_exited_stack);
+    task_exited_stack = 0;
+  }
+}
+
+// Set up a new kernel stack so the first switch to it returns into the entry function
+static int task_kernel_stack_init(struct task_t *task, void (*entry)())
+{
+  task->kernel_stack = kernel_zalloc_pages(TASK_KERNEL_STACK_SIZE);
+  if (!task->kernel_stack)
+  {
+    return -ENOMEM;
   }
+
+  uint32_t *sp = (uint32_t *)(task->kernel_stack + TASK_KERNEL_STACK_SIZE);
+  // The entry function never returns
+  *--sp = 0;
+  // Where task_switch_stack returns to
+  *--sp = (uint32_t)entry;
+  // The ebp, ebx, esi and edi task_switch_stack pops
+  *--sp = 0;
+  *--sp = 0;
+  *--sp = 0;
+  *--sp = 0;
+  task->kernel_esp = (uint32_t)sp;
+  return 0;
+}
+
+// Where a new task starts in the kernel, it drops to user land with the registers task_init gave it
+static void task_enter_user()
+{
+  task_switch_finish();
+  task_return(&current_task->registers);
 }
 
 int task_free(struct task_t *task)
 {
+  // Never free the directory or the stack the processor is still using
+  if (task == current_task)
+  {
+    switch_to_kernel_page();
+    task_switch_finish();
+    task_exited_stack = task->kernel_stack;
+  }
+  else if (task->kernel_stack)
+  {
+    kernel_free(task->kernel_stack);
+  }
+
   paging_free_4GB(task->page_directory);
   task_list_remove(task);
 
   // Finally free the task data
-  kernel_free(task);
+  kmem_cache_free(task_cache, task);
   return 0;
 }
 
+bool task_is_idle(struct task_t *task)
+{
+  return task == &idle_task;
+}
+
+// Whether the kernel runs for a task that may sleep, not during boot or in the idle task
+bool task_can_block()
+{
+  return task_scheduling && current_task && !task_is_idle(current_task);
+}
+
+// Halt until an interrupt makes a task runnable, then hand the processor over to it
+static void task_idle_loop()
+{
+  task_switch_finish();
+  kernel_registers();
+  while (1)
+  {
+    if (task_run_queue_bitmap)
+    {
+#if TASK_TICKLESS_IDLE
+      idt_clock_start();
+#endif
+      // We are back once every task is blocked again
+      task_next();
+      continue;
+    }
+
+#if TASK_TICKLESS_IDLE
+    // Without timers nothing can become runnable on a clock tick, let the device interrupts wake us
+    if (!timer_wheel_pending())
+    {
+      idt_clock_stop();
+    }
+#endif
+
+    uint64_t start = read_tsc();
+    wait_for_interrupt();
+    idle_task_idle_cycles += read_tsc() - start;
+
+    // The interrupt return path leaves the user data segments loaded
+    kernel_registers();
+  }
+}
+
+// Create the idle task, it runs on the kernel page directory with its own stack
+void task_idle_init(struct paging_4GB_chunk_t *kernel_directory)
+{
+  memset(&idle_task, 0, sizeof(idle_task));
+  idle_task.page_directory = kernel_directory;
+  idle_task.priority = TASK_PRIORITY_LEVELS - 1;
+  idle_task.nice = TASK_NICE_MAX;
+
+  if (task_kernel_stack_init(&idle_task, task_idle_loop) < 0)
+  {
+    PANIC("Failed to allocate the idle task stack\n");
+  }
+
+  idle_task_idle_cycles = 0;
+  idle_task_start_cycles = read_tsc();
+}
+
+void task_idle_stats(struct task_idle_stats_t *stats)
+{
+  stats->total_cycles = read_tsc() - idle_task_start_cycles;
+  stats->idle_cycles = idle_task_idle_cycles;
+}
+
+// Switch to another task's kernel stack, this returns once the current task is switched back to
+void task_yield_to(struct task_t *task)
+{
+  struct task_t *prev = current_task;
+  task_switch(task);
+  if (task == prev)
+  {
+    return;
+  }
+
+  // A task that exited has nowhere left to save its stack pointer
+  task_switch_stack(prev ? &prev->kernel_esp : &task_exited_esp, task->kernel_esp);
+  task_switch_finish();
+}
+
+// Run the best task that is ready, the current one resumes from here when it is picked again
 void task_next()
 {
+  // The current task competes with the ready ones at its own level
+  if (current_task && current_task->state == TASK_STATE_RUNNABLE && !current_task->queued && !task_is_idle(current_task))
+  {
+    task_run_queue_add(current_task);
+  }
+
   struct task_t *next_task = task_get_next();
-  if (!next_task)
+  if (!next_task || !task_head)
   {
     PANIC("No more tasks!\n");
   }
 
-  task_switch(next_task);
-  task_return(&next_task->registers);
+  task_yield_to(next_task);
 }
 
 int task_switch(struct task_t *task)
 {
+  // The task we leave waits its turn again, the one we run leaves its run queue
+  if (current_task && current_task != task && current_task->state == TASK_STATE_RUNNABLE && !current_task->queued && !task_is_idle(current_task))
+  {
+    task_run_queue_add(current_task);
+  }
+
+  if (task->queued)
+  {
+    task_run_queue_remove(task);
+  }
+
   current_task = task;
+  // Interrupts and syscalls from user land come in on the task's own kernel stack
+  kernel_tss.esp0 = (uint32_t)(task->kernel_stack + TASK_KERNEL_STACK_SIZE);
   paging_switch(task->page_directory);
   return 0;
 }
 
+// Move every task back up to its nice level
+static void task_boost_all()
+{
+  for (struct task_t *task = task_head; task; task = task->next)
+  {
+    task_set_priority(task, task->nice);
+  }
+}
+
+// Account a clock tick to the current task and preempt it once its slice is used up
+// or a task with a better priority is ready
+void task_tick()
+{
+  struct task_t *task = current_task;
+  if (!task || task_is_idle(task))
+  {
+    return;
+  }
+
+  if (++task_boost_ticks >= TASK_BOOST_TICKS)
+  {
+    task_boost_ticks = 0;
+    task_boost_all();
+  }
+
+  task->slice_left--;
+  if (task->slice_left <= 0)
+  {
+    // It used its whole slice, treat it as CPU bound and drop a level
+    if (task->priority < TASK_PRIORITY_LEVELS - 1)
+    {
+      task->priority++;
+    }
+
+    task->slice_left = task_time_slice(task);
+    task_next();
+    return;
+  }
+
+  if (task_run_queue_bitmap & ((1 << task->priority) - 1))
+  {
+    task_next();
+  }
+}
+
+// A task that got input is interactive, give it its best level back so it responds quickly
+void task_boost(struct task_t *task)
+{
+  if (task->priority != task->nice)
+  {
+    task_set_priority(task, task->nice);
+  }
+}
+
+// Stop scheduling a task until task_wake
+void task_block(struct task_t *task)
+{
+  task->state = TASK_STATE_BLOCKED;
+  if (task->queued)
+  {
+    task_run_queue_remove(task);
+  }
+}
+
+// Make a blocked task runnable, it waited for I/O so it gets its best level back
+void task_wake(struct task_t *task)
+{
+  if (task->state != TASK_STATE_BLOCKED)
+  {
+    return;
+  }
+
+  task->state = TASK_STATE_RUNNABLE;
+  task->priority = task->nice;
+  task->slice_left = task_time_slice(task);
+  task_run_queue_add(task);
+}
+
+static void task_sleep_expired(struct timer_t *timer)
+{
+  task_wake(timer->data);
+}
+
+// Block the current task for at least ns nanoseconds and run something else until then
+void task_sleep(uint64_t ns)
+{
+  struct task_t *task = current_task;
+  uint64_t now = timer_now_ns();
+  uint64_t deadline = now + ns;
+  if (deadline < now)
+  {
+    deadline = UINT64_MAX;
+  }
+
+  // The wheel only reaches TIMER_WHEEL_MAX_TICKS ahead, a longer sleep is made of several timers
+  while (now < deadline)
+  {
+    timer_add_ns(&task->sleep_timer, deadline - now);
+    task_block(task);
+    task_next();
+    now = timer_now_ns();
+  }
+}
+
+int task_set_nice(struct task_t *task, int nice)
+{
+  if (nice < TASK_NICE_MIN || nice > TASK_NICE_MAX)
+  {
+    return -EINVARG;
+  }
+
+  task->nice = nice;
+  task_set_priority(task, nice);
+  return 0;
+}
+
 void task_save_state(struct task_t *task, struct interrupt_frame_t *frame)
 {
   task->registers.ip = frame->ip;
@@ -139,41 +546,124 @@ void task_save_state(struct task_t *task, struct interrupt_frame_t *frame)
   task->registers.esi = frame->esi;
 }
 
-int copy_string_from_task(struct task_t *task, void *virtual_addr, void *physical_addr, int max)
+// Resolve a task's virtual address to the kernel's identity mapped view of it,
+// checking that the task itself may access the page
+static void *task_user_address(struct task_t *task, void *virtual_addr, bool write)
 {
-  if (max >= PAGING_PAGE_SIZE)
+  uint32_t *directory = task->page_directory->directory_entry;
+  uint32_t entry = paging_get(directory, paging_align_to_lower_page(virtual_addr));
+  if (!(entry & PAGING_IS_PRESENT) || !(entry & PAGING_ACCESS_FROM_ALL))
   {
-    return -EINVARG;
+    return 0;
   }
 
-  int res = 0;
-  char *tmp = kernel_zalloc(max);
-  if (!tmp)
+  if (write && !(entry & PAGING_IS_WRITEABLE))
   {
-    res = -ENOMEM;
-    goto out;
+    return 0;
   }
 
-  uint32_t *task_directory = task->page_directory->directory_entry;
-  uint32_t old_entry = paging_get(task_directory, tmp);
-  paging_map(task->page_directory, tmp, tmp, PAGING_IS_WRITEABLE | PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL);
-  paging_switch(task->page_directory);
-  strncpy(tmp, virtual_addr, max);
-  switch_to_kernel_page();
+  return paging_get_physical_address(directory, virtual_addr);
+}
 
-  res = paging_set(task_directory, tmp, old_entry);
-  if (res < 0)
+// Bytes left in the page holding the address
+static size_t task_page_remaining(void *virtual_addr)
+{
+  return PAGING_PAGE_SIZE - ((uint32_t)virtual_addr % PAGING_PAGE_SIZE);
+}
+
+// Copy memory out of a task's address space, one page at a time through its page tables
+int copy_from_user(struct task_t *task, void *dst, void *user_src, size_t size)
+{
+  char *out = dst;
+  char *in = user_src;
+  while (size > 0)
   {
-    res = -EIO;
-    goto out_free;
+    char *src = task_user_address(task, in, false);
+    if (!src)
+    {
+      return -EINVARG;
+    }
+
+    size_t chunk = task_page_remaining(in);
+    if (chunk > size)
+    {
+      chunk = size;
+    }
+
+    memcpy(out, src, chunk);
+    out += chunk;
+    in += chunk;
+    size -= chunk;
   }
 
-  strncpy(physical_addr, tmp, max);
+  return 0;
+}
 
-out_free:
-  kernel_free(tmp);
-out:
-  return res;
+// Copy memory into a task's address space, one page at a time through its page tables
+int copy_to_user(struct task_t *task, void *user_dst, void *src, size_t size)
+{
+  char *out = user_dst;
+  char *in = src;
+  while (size > 0)
+  {
+    char *dst = task_user_address(task, out, true);
+    if (!dst)
+    {
+      return -EINVARG;
+    }
+
+    size_t chunk = task_page_remaining(out);
+    if (chunk > size)
+    {
+      chunk = size;
+    }
+
+    memcpy(dst, in, chunk);
+    out += chunk;
+    in += chunk;
+    size -= chunk;
+  }
+
+  return 0;
+}
+
+// Copy a string out of a task's address space, truncating it to fit max bytes including the terminator.
+// Returns the length of the copied string
+int strncpy_from_user(struct task_t *task, char *dst, void *user_src, int max)
+{
+  if (max <= 0)
+  {
+    return -EINVARG;
+  }
+
+  char *in = user_src;
+  int len = 0;
+  while (len < max - 1)
+  {
+    char *src = task_user_address(task, in, false);
+    if (!src)
+    {
+      dst[len] = 0;
+      return -EINVARG;
+    }
+
+    size_t chunk = task_page_remaining(in);
+    for (size_t i = 0; i < chunk && len < max - 1; i++)
+    {
+      if (!src[i])
+      {
+        dst[len] = 0;
+        return len;
+      }
+
+      dst[len++] = src[i];
+    }
+
+    in += chunk;
+  }
+
+  dst[len] = 0;
+  return len;
 }
 void task_current_save_state(struct interrupt_frame_t *frame)
 {
@@ -207,20 +697,29 @@ void task_run_first_ever_task()
     PANIC("task_run_first_ever_task(): No current task exists!\n");
   }
 
-  task_switch(task_head);
-  task_return(&task_head->registers);
+  // Nothing ever switches back to the boot stack
+  struct task_t *task = task_get_next();
+  task_scheduling = true;
+  task_switch(task);
+  task_switch_stack(&task_exited_esp, task->kernel_esp);
 }
 
 int task_init(struct task_t *task, struct process_t *process)
 {
   memset(task, 0, sizeof(struct task_t));
-  // Map the entire 4GB address space to its self
-  task->page_directory = paging_new_4GB(PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL);
+  // Identity map the kernel memory, everything else is mapped on demand
+  task->page_directory = paging_new_4GB();
   if (!task->page_directory)
   {
     return -EIO;
   }
 
+  int res = task_kernel_stack_init(task, task_enter_user);
+  if (res < 0)
+  {
+    return res;
+  }
+
   task->registers.ip = PROGRAM_VIRTUAL_ADDRESS;
   if (process->filetype == PROCESS_FILETYPE_ELF)
   {
@@ -233,6 +732,11 @@ int task_init(struct task_t *task, struct process_t *process)
 
   task->process = process;
 
+  task->priority = TASK_NICE_MIN;
+  task->nice = TASK_NICE_MIN;
+  task->slice_left = task_time_slice(task);
+  timer_setup(&task->sleep_timer, task_sleep_expired, task);
+
   return 0;
 }
 
@@ -242,13 +746,11 @@ void *task_get_stack_item(struct task_t *task, int index)
 
   uint32_t *sp_ptr = (uint32_t *)task->registers.esp;
 
-  // Switch to the given tasks page
-  task_page_task(task);
-
-  result = (void *)sp_ptr[index];
-
-  // Switch back to the kernel page
-  switch_to_kernel_page();
+  // The stack pointer comes from user space, it is only read through the task's user mappings
+  if (copy_from_user(task, &result, &sp_ptr[index], sizeof(result)) < 0)
+  {
+    return 0;
+  }
 
   return result;
 }
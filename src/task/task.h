@@ -2,10 +2,26 @@
 #define TASK_H
 
 #include <common/system.h>
+#include <stdbool.h>
 #include <mm/paging/paging.h>
+#include <timer/wheel.h>
 
 struct interrupt_frame_t;
 
+// Run queue levels of the multi-level feedback scheduler, level 0 runs first
+#define TASK_PRIORITY_LEVELS 8
+// A nice value is the best level a task can run at
+#define TASK_NICE_MIN 0
+#define TASK_NICE_MAX (TASK_PRIORITY_LEVELS - 1)
+// Clock ticks in the time slice of level 0, each level down adds as much again (10ms)
+#define TASK_SLICE_TICKS (TIMER_FREQUENCY_HZ / 100)
+// Clock ticks between moving every task back up to its nice level, so CPU bound tasks are not starved (500ms)
+#define TASK_BOOST_TICKS (TIMER_FREQUENCY_HZ / 2)
+
+// A runnable task is running or waiting in a run queue, a blocked one sleeps on a wait queue
+#define TASK_STATE_RUNNABLE 0
+#define TASK_STATE_BLOCKED 1
+
 // This structure represents the state of the CPU registers.
 // It's often used in context switching, where the operating system needs to save the state of the current process so it can be restored later.
 // The specific registers and their uses can vary depending on the CPU architecture.
@@ -27,6 +43,14 @@ struct register_state_t
 };
 
 struct process_t;
+struct wait_queue_t;
+
+// Time spent by the idle task since it was created
+struct task_idle_stats_t
+{
+  uint64_t total_cycles;
+  uint64_t idle_cycles;
+};
 struct task_t
 {
   /**
@@ -45,14 +69,59 @@ struct task_t
 
   // Previous task in the linked list
   struct task_t *prev;
+
+  // The run queue level the task is scheduled at
+  int priority;
+
+  // The best level the task may run at
+  int nice;
+
+  // Clock ticks left before the task is preempted
+  int slice_left;
+
+  // Whether the task is waiting in a run queue
+  bool queued;
+
+  // The links of the run queue the task is waiting in
+  struct task_t *run_next;
+  struct task_t *run_prev;
+
+  // Whether the task can run or sleeps until it is woken
+  int state;
+
+  // The wait queue the task sleeps on and the next task sleeping there
+  struct wait_queue_t *wait_queue;
+  struct task_t *wait_next;
+
+  // Wakes the task up when it sleeps for a while
+  struct timer_t sleep_timer;
+
+  // The stack the task runs on in the kernel and its stack pointer while another task runs
+  void *kernel_stack;
+  uint32_t kernel_esp;
+
+  // Whether the syscall the task is in passed its arguments in registers
+  bool syscall_register_args;
 };
 
+void task_cache_init();
 struct task_t *new_task(struct process_t *process);
 struct task_t *task_current();
 struct task_t *task_get_next();
 int task_free(struct task_t *task);
+void task_tick();
+void task_boost(struct task_t *task);
+void task_block(struct task_t *task);
+void task_wake(struct task_t *task);
+void task_sleep(uint64_t ns);
+void task_idle_init(struct paging_4GB_chunk_t *kernel_directory);
+bool task_is_idle(struct task_t *task);
+bool task_can_block();
+void task_idle_stats(struct task_idle_stats_t *stats);
+int task_set_nice(struct task_t *task, int nice);
 
 int task_switch(struct task_t *task);
+void task_yield_to(struct task_t *task);
 int switch_to_task_page();
 int task_page_task(struct task_t *task);
 
@@ -61,9 +130,12 @@ void task_run_first_ever_task();
 extern void task_return(struct register_state_t *regs);
 extern void restore_registers_state_t(struct register_state_t *regs);
 extern void user_registers();
+extern void task_switch_stack(uint32_t *old_esp, uint32_t new_esp);
 
 void task_current_save_state(struct interrupt_frame_t *frame);
-int copy_string_from_task(struct task_t *task, void *virtual_addr, void *physical_addr, int max);
+int copy_from_user(struct task_t *task, void *dst, void *user_src, size_t size);
+int copy_to_user(struct task_t *task, void *user_dst, void *src, size_t size);
+int strncpy_from_user(struct task_t *task, char *dst, void *user_src, int max);
 void *task_get_stack_item(struct task_t *task, int index);
 void *task_virtual_address_to_physical(struct task_t *task, void *virtual_addr);
 void task_next();
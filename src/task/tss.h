@@ -34,5 +34,7 @@ struct tss_entry_t
   uint16_t iomap_base;
 } __attribute__((packed));
 
+extern struct tss_entry_t kernel_tss;
+
 extern void tss_load(int tss_segment);
 #endif
\ No newline at end of file
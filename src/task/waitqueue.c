@@ -0,0 +1,85 @@
+#include <task/waitqueue.h>
+#include <task/task.h>
+
+void wait_queue_init(struct wait_queue_t *queue)
+{
+  queue->head = 0;
+  queue->tail = 0;
+}
+
+// Block the current task on the queue and run something else, this returns once the task is woken
+void wait_queue_sleep(struct wait_queue_t *queue)
+{
+  struct task_t *task = task_current();
+  task->wait_next = 0;
+  task->wait_queue = queue;
+  if (queue->tail)
+  {
+    queue->tail->wait_next = task;
+  }
+  else
+  {
+    queue->head = task;
+  }
+
+  queue->tail = task;
+
+  task_block(task);
+  task_next();
+}
+
+// Make every task on the queue runnable again
+void wait_queue_wake_all(struct wait_queue_t *queue)
+{
+  struct task_t *task = queue->head;
+  queue->head = 0;
+  queue->tail = 0;
+
+  while (task)
+  {
+    struct task_t *next = task->wait_next;
+    task->wait_next = 0;
+    task->wait_queue = 0;
+    task_wake(task);
+    task = next;
+  }
+}
+
+// Take a task off the queue it sleeps on without waking it, used when the task goes away
+void wait_queue_remove(struct task_t *task)
+{
+  struct wait_queue_t *queue = task->wait_queue;
+  if (!queue)
+  {
+    return;
+  }
+
+  struct task_t *prev = 0;
+  for (struct task_t *current = queue->head; current; current = current->wait_next)
+  {
+    if (current != task)
+    {
+      prev = current;
+      continue;
+    }
+
+    if (prev)
+    {
+      prev->wait_next = task->wait_next;
+    }
+    else
+    {
+      queue->head = task->wait_next;
+    }
+
+    if (queue->tail == task)
+    {
+      queue->tail = prev;
+    }
+
+    break;
+  }
+
+  task->wait_next = 0;
+  task->wait_queue = 0;
+}
@@ -0,0 +1,18 @@
+#ifndef WAITQUEUE_H
+#define WAITQUEUE_H
+
+struct task_t;
+
+// Tasks blocked until some event, in the order they went to sleep
+struct wait_queue_t
+{
+  struct task_t *head;
+  struct task_t *tail;
+};
+
+void wait_queue_init(struct wait_queue_t *queue);
+void wait_queue_sleep(struct wait_queue_t *queue);
+void wait_queue_wake_all(struct wait_queue_t *queue);
+void wait_queue_remove(struct task_t *task);
+
+#endif
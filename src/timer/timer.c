@@ -0,0 +1,137 @@
+#include "timer.h"
+#include "wheel.h"
+#include "common/system.h"
+#include "io/io.h"
+#include "kernel/kernel.h"
+
+// TSC cycles counted during one calibration period
+static uint32_t timer_calibration_cycles = 0;
+
+// Nanoseconds per TSC cycle, shifted left by TIMER_NS_SCALE_SHIFT
+static uint32_t timer_ns_per_cycle = 0;
+
+// The TSC when the clock started, the monotonic clock counts from here
+static uint64_t timer_start_cycles = 0;
+
+// Clock interrupts since boot, they stop while the idle task masks the clock
+static uint64_t timer_tick_count = 0;
+
+// 64 by 32 bit division by shift and subtract, the kernel is not linked against libgcc
+uint64_t timer_divide(uint64_t dividend, uint32_t divisor, uint32_t *remainder_out)
+{
+  uint64_t quotient = 0;
+  uint64_t remainder = 0;
+  for (int i = 63; i >= 0; i--)
+  {
+    remainder = (remainder << 1) | ((dividend >> i) & 1);
+    if (remainder >= divisor)
+    {
+      remainder -= divisor;
+      quotient |= (uint64_t)1 << i;
+    }
+  }
+
+  if (remainder_out)
+  {
+    *remainder_out = (uint32_t)remainder;
+  }
+
+  return quotient;
+}
+
+// Count TSC cycles while channel 2 counts down one calibration period with the speaker off
+static void timer_calibrate_tsc()
+{
+  uint32_t count = PIT_BASE_FREQUENCY / PIT_CALIBRATION_HZ;
+
+  write_byte(PIT_CHANNEL2_GATE, (read_byte(PIT_CHANNEL2_GATE) & ~0x02) | 0x01);
+
+  // Channel 2, low then high byte, mode 0 (interrupt on terminal count)
+  write_byte(PIT_COMMAND, 0xB0);
+  write_byte(PIT_CHANNEL2, count & 0xFF);
+  write_byte(PIT_CHANNEL2, (count >> 8) & 0xFF);
+
+  // Restart the count by toggling the gate
+  uint8_t gate = read_byte(PIT_CHANNEL2_GATE) & ~0x01;
+  write_byte(PIT_CHANNEL2_GATE, gate);
+  write_byte(PIT_CHANNEL2_GATE, gate | 0x01);
+
+  uint64_t start = read_tsc();
+  while (!(read_byte(PIT_CHANNEL2_GATE) & 0x20))
+  {
+  }
+
+  timer_calibration_cycles = (uint32_t)(read_tsc() - start);
+  if (!timer_calibration_cycles)
+  {
+    PANIC("Failed to calibrate the TSC\n");
+  }
+
+  uint64_t ns_per_period = NANOSECONDS_PER_SECOND / PIT_CALIBRATION_HZ;
+  timer_ns_per_cycle = (uint32_t)timer_divide(ns_per_period << TIMER_NS_SCALE_SHIFT, timer_calibration_cycles, 0);
+}
+
+// Program channel 0 to interrupt at the given rate
+static void timer_set_frequency(uint32_t hz)
+{
+  uint32_t divisor = PIT_BASE_FREQUENCY / hz;
+
+  // Channel 0, low then high byte, mode 2 (rate generator)
+  write_byte(PIT_COMMAND, 0x34);
+  write_byte(PIT_CHANNEL0, divisor & 0xFF);
+  write_byte(PIT_CHANNEL0, (divisor >> 8) & 0xFF);
+}
+
+void timer_init()
+{
+  timer_tick_count = 0;
+  timer_calibrate_tsc();
+  timer_set_frequency(TIMER_FREQUENCY_HZ);
+  timer_start_cycles = read_tsc();
+  timer_wheel_init();
+}
+
+void timer_tick()
+{
+  timer_tick_count++;
+}
+
+uint64_t timer_ticks()
+{
+  return timer_tick_count;
+}
+
+uint64_t timer_tsc_frequency()
+{
+  return (uint64_t)timer_calibration_cycles * PIT_CALIBRATION_HZ;
+}
+
+uint64_t timer_cycles_to_ns(uint64_t cycles)
+{
+  // Split the cycles so both products fit in 64 bits
+  uint64_t high = (cycles >> 32) * timer_ns_per_cycle;
+  uint64_t low = (cycles & 0xFFFFFFFF) * timer_ns_per_cycle;
+  return (high << (32 - TIMER_NS_SCALE_SHIFT)) + (low >> TIMER_NS_SCALE_SHIFT);
+}
+
+// Nanoseconds since the clock started, never goes backwards
+uint64_t timer_now_ns()
+{
+  return timer_cycles_to_ns(read_tsc() - timer_start_cycles);
+}
+
+void timer_ns_to_timespec(uint64_t ns, struct timespec_t *ts)
+{
+  uint32_t remainder = 0;
+  ts->tv_sec = (uint32_t)timer_divide(ns, NANOSECONDS_PER_SECOND, &remainder);
+  ts->tv_nsec = remainder;
+}
+
+// Clock ticks covering at least ns nanoseconds
+uint64_t timer_ns_to_ticks(uint64_t ns)
+{
+  // Round up from the remainder, adding a tick's worth of ns first overflows near 2^64
+  uint32_t remainder = 0;
+  uint64_t ticks = timer_divide(ns, NANOSECONDS_PER_TICK, &remainder);
+  return remainder ? ticks + 1 : ticks;
+}
@@ -0,0 +1,42 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+// The 8253/8254 programmable interval timer
+#define PIT_BASE_FREQUENCY 1193182
+#define PIT_CHANNEL0 0x40
+#define PIT_CHANNEL2 0x42
+#define PIT_COMMAND 0x43
+// Gate of channel 2 (bit 0), speaker enable (bit 1) and channel 2 output (bit 5)
+#define PIT_CHANNEL2_GATE 0x61
+
+// The TSC is counted against channel 2 for 1/PIT_CALIBRATION_HZ of a second
+#define PIT_CALIBRATION_HZ 100
+
+// Fixed point shift of the nanoseconds per TSC cycle
+#define TIMER_NS_SCALE_SHIFT 24
+
+#define NANOSECONDS_PER_SECOND 1000000000
+#define NANOSECONDS_PER_TICK (NANOSECONDS_PER_SECOND / TIMER_FREQUENCY_HZ)
+
+// Clocks readable with clock_gettime
+#define CLOCK_MONOTONIC 0
+
+struct timespec_t
+{
+  uint32_t tv_sec;
+  uint32_t tv_nsec;
+};
+
+void timer_init();
+void timer_tick();
+uint64_t timer_ticks();
+uint64_t timer_tsc_frequency();
+uint64_t timer_cycles_to_ns(uint64_t cycles);
+uint64_t timer_now_ns();
+void timer_ns_to_timespec(uint64_t ns, struct timespec_t *ts);
+uint64_t timer_ns_to_ticks(uint64_t ns);
+uint64_t timer_divide(uint64_t dividend, uint32_t divisor, uint32_t *remainder_out);
+
+#endif
@@ -0,0 +1,166 @@
+#include "wheel.h"
+#include "timer.h"
+#include "mm/memory.h"
+
+static struct timer_link_t timer_wheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+
+// The next tick the wheel has to process
+static uint64_t timer_wheel_now = 0;
+
+// Timers waiting in the wheel
+static int timer_wheel_count = 0;
+
+void timer_wheel_init()
+{
+  for (int level = 0; level < TIMER_WHEEL_LEVELS; level++)
+  {
+    for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++)
+    {
+      timer_wheel[level][slot].next = &timer_wheel[level][slot];
+      timer_wheel[level][slot].prev = &timer_wheel[level][slot];
+    }
+  }
+
+  timer_wheel_now = timer_ticks();
+  timer_wheel_count = 0;
+}
+
+static void timer_link_add(struct timer_link_t *slot, struct timer_link_t *link)
+{
+  link->next = slot;
+  link->prev = slot->prev;
+  slot->prev->next = link;
+  slot->prev = link;
+}
+
+static void timer_link_remove(struct timer_link_t *link)
+{
+  link->prev->next = link->next;
+  link->next->prev = link->prev;
+  link->next = link;
+  link->prev = link;
+}
+
+// Put a timer in the slot of the lowest level that reaches its expiry
+static void timer_wheel_insert(struct timer_t *timer)
+{
+  uint64_t expires = timer->expires;
+  if (expires < timer_wheel_now)
+  {
+    // Already due, it fires on the next tick processed
+    expires = timer_wheel_now;
+  }
+
+  uint64_t delta = expires - timer_wheel_now;
+  int level = 0;
+  while (level < TIMER_WHEEL_LEVELS - 1 && delta >= ((uint64_t)1 << (TIMER_WHEEL_BITS * (level + 1))))
+  {
+    level++;
+  }
+
+  int slot = (expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+  timer_link_add(&timer_wheel[level][slot], &timer->link);
+}
+
+// Move the timers of a slot down, now that they are closer than the slot's level covers
+static int timer_wheel_cascade(int level, int slot)
+{
+  struct timer_link_t *head = &timer_wheel[level][slot];
+  struct timer_link_t list = *head;
+  if (list.next == head)
+  {
+    return slot;
+  }
+
+  // Detach the slot so re-inserted timers can not land back in the list being walked
+  list.next->prev = &list;
+  list.prev->next = &list;
+  head->next = head;
+  head->prev = head;
+
+  while (list.next != &list)
+  {
+    struct timer_t *timer = (struct timer_t *)list.next;
+    timer_link_remove(&timer->link);
+    timer_wheel_insert(timer);
+  }
+
+  return slot;
+}
+
+// Process every tick up to now: cascade the higher levels when a lower one wraps, then fire the due slot
+void timer_wheel_run(uint64_t now)
+{
+  while (timer_wheel_now <= now)
+  {
+    int index = timer_wheel_now & TIMER_WHEEL_MASK;
+    for (int level = 1; index == 0 && level < TIMER_WHEEL_LEVELS; level++)
+    {
+      index = timer_wheel_cascade(level, (timer_wheel_now >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+    }
+
+    struct timer_link_t *head = &timer_wheel[0][timer_wheel_now & TIMER_WHEEL_MASK];
+    timer_wheel_now++;
+
+    while (head->next != head)
+    {
+      struct timer_t *timer = (struct timer_t *)head->next;
+      timer_link_remove(&timer->link);
+      timer->pending = false;
+      timer_wheel_count--;
+      timer->function(timer);
+    }
+  }
+}
+
+bool timer_wheel_pending()
+{
+  return timer_wheel_count > 0;
+}
+
+void timer_setup(struct timer_t *timer, timer_function_t function, void *data)
+{
+  memset(timer, 0, sizeof(struct timer_t));
+  timer->link.next = &timer->link;
+  timer->link.prev = &timer->link;
+  timer->function = function;
+  timer->data = data;
+}
+
+// Arm a timer for an absolute tick, re-arming a pending timer moves it
+void timer_add(struct timer_t *timer, uint64_t expires)
+{
+  if (timer->pending)
+  {
+    timer_cancel(timer);
+  }
+
+  if (expires > timer_wheel_now + TIMER_WHEEL_MAX_TICKS)
+  {
+    expires = timer_wheel_now + TIMER_WHEEL_MAX_TICKS;
+  }
+
+  timer->expires = expires;
+  timer->pending = true;
+  timer_wheel_count++;
+  timer_wheel_insert(timer);
+}
+
+// Arm a timer at least ns nanoseconds from now
+void timer_add_ns(struct timer_t *timer, uint64_t ns)
+{
+  // The current tick is partly gone already, wait one more
+  timer_add(timer, timer_ticks() + timer_ns_to_ticks(ns) + 1);
+}
+
+void timer_cancel(struct timer_t *timer)
+{
+  if (!timer->pending)
+  {
+    return;
+  }
+
+  timer_link_remove(&timer->link);
+  timer->pending = false;
+  timer_wheel_count--;
+}
@@ -0,0 +1,43 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Four levels of 64 slots, level n slots cover 64^n ticks so the wheel reaches 64^4 ticks ahead
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_MAX_TICKS (((uint64_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+struct timer_t;
+typedef void (*timer_function_t)(struct timer_t *timer);
+
+// Links of a timer in a wheel slot, each slot is a circular list around its own link
+struct timer_link_t
+{
+  struct timer_link_t *next;
+  struct timer_link_t *prev;
+};
+
+// A one shot timer, the function runs from the clock interrupt once the expiry tick has passed
+struct timer_t
+{
+  struct timer_link_t link;
+  uint64_t expires;
+  timer_function_t function;
+  void *data;
+  bool pending;
+};
+
+void timer_wheel_init();
+void timer_wheel_run(uint64_t now);
+bool timer_wheel_pending();
+
+void timer_setup(struct timer_t *timer, timer_function_t function, void *data);
+void timer_add(struct timer_t *timer, uint64_t expires);
+void timer_add_ns(struct timer_t *timer, uint64_t ns);
+void timer_cancel(struct timer_t *timer);
+
+#endif
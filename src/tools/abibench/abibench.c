@@ -0,0 +1,169 @@
+#include "os.h"
+#include "stdlib.h"
+#include "stdio.h"
+#include <stdint.h>
+
+// A power of two so the per call cost is a shift, there is no 64 bit division without libgcc
+#define ABIBENCH_CALLS_SHIFT 14
+#define ABIBENCH_CALLS (1 << ABIBENCH_CALLS_SHIFT)
+
+// Arguments in ebx, ecx, edx, esi and edi, without it the kernel reads them from the user stack
+#define ABIBENCH_REGISTER_ARGS 0x80000000
+
+#define ABIBENCH_GETKEY 1
+#define ABIBENCH_IDLE_STATS 14
+#define ABIBENCH_CLOCK_GETTIME 15
+
+static inline uint64_t rdtsc()
+{
+  uint32_t low, high;
+  asm volatile("rdtsc" : "=a"(low), "=d"(high));
+  return ((uint64_t)high << 32) | low;
+}
+
+// The stack ABI: arguments pushed right to left, the kernel copies them off the user stack
+static inline int stack_call0(int command)
+{
+  int res;
+  asm volatile("int $0x80" : "=a"(res) : "a"(command) : "memory");
+  return res;
+}
+
+static inline int stack_call1(int command, uint32_t arg0)
+{
+  int res;
+  asm volatile("pushl %1\n\t"
+               "int $0x80\n\t"
+               "addl $4, %%esp"
+               : "=a"(res)
+               : "r"(arg0), "a"(command)
+               : "memory");
+  return res;
+}
+
+static inline int stack_call2(int command, uint32_t arg0, uint32_t arg1)
+{
+  int res;
+  asm volatile("pushl %2\n\t"
+               "pushl %1\n\t"
+               "int $0x80\n\t"
+               "addl $8, %%esp"
+               : "=a"(res)
+               : "r"(arg0), "r"(arg1), "a"(command)
+               : "memory");
+  return res;
+}
+
+// The register ABI through the same int 0x80 gate, only the argument passing differs
+static inline int register_call0(int command)
+{
+  int res;
+  asm volatile("int $0x80" : "=a"(res) : "a"(ABIBENCH_REGISTER_ARGS | command) : "memory");
+  return res;
+}
+
+static inline int register_call1(int command, uint32_t arg0)
+{
+  int res;
+  asm volatile("int $0x80" : "=a"(res) : "a"(ABIBENCH_REGISTER_ARGS | command), "b"(arg0) : "memory");
+  return res;
+}
+
+static inline int register_call2(int command, uint32_t arg0, uint32_t arg1)
+{
+  int res;
+  asm volatile("int $0x80" : "=a"(res) : "a"(ABIBENCH_REGISTER_ARGS | command), "b"(arg0), "c"(arg1) : "memory");
+  return res;
+}
+
+static void abibench_report(const char *name, const char *abi, uint64_t cycles)
+{
+  printf("%s %s: %u cycles per call\n", name, abi, (uint32_t)(cycles >> ABIBENCH_CALLS_SHIFT));
+}
+
+// getkey returns at once when no key is waiting, so it is the bare cost of a round trip
+static void abibench_getkey()
+{
+  uint64_t start = rdtsc();
+  for (int i = 0; i < ABIBENCH_CALLS; i++)
+  {
+    stack_call0(ABIBENCH_GETKEY);
+  }
+  abibench_report("getkey", "stack", rdtsc() - start);
+
+  start = rdtsc();
+  for (int i = 0; i < ABIBENCH_CALLS; i++)
+  {
+    register_call0(ABIBENCH_GETKEY);
+  }
+  abibench_report("getkey", "register", rdtsc() - start);
+
+  // The stdlib stub enters through SYSENTER when the kernel enabled it
+  if (!sys_sysenter_enabled())
+  {
+    printf("getkey sysenter: not enabled\n");
+    return;
+  }
+
+  start = rdtsc();
+  for (int i = 0; i < ABIBENCH_CALLS; i++)
+  {
+    sys_getkey();
+  }
+  abibench_report("getkey", "sysenter", rdtsc() - start);
+}
+
+static void abibench_idle_stats()
+{
+  struct idle_stats_t stats;
+  uint64_t start = rdtsc();
+  for (int i = 0; i < ABIBENCH_CALLS; i++)
+  {
+    stack_call1(ABIBENCH_IDLE_STATS, (uint32_t)&stats);
+  }
+  abibench_report("idle_stats", "stack", rdtsc() - start);
+
+  start = rdtsc();
+  for (int i = 0; i < ABIBENCH_CALLS; i++)
+  {
+    register_call1(ABIBENCH_IDLE_STATS, (uint32_t)&stats);
+  }
+  abibench_report("idle_stats", "register", rdtsc() - start);
+}
+
+static void abibench_clock_gettime()
+{
+  struct timespec_t ts;
+  uint64_t start = rdtsc();
+  for (int i = 0; i < ABIBENCH_CALLS; i++)
+  {
+    stack_call2(ABIBENCH_CLOCK_GETTIME, CLOCK_MONOTONIC, (uint32_t)&ts);
+  }
+  abibench_report("clock_gettime", "stack", rdtsc() - start);
+
+  start = rdtsc();
+  for (int i = 0; i < ABIBENCH_CALLS; i++)
+  {
+    register_call2(ABIBENCH_CLOCK_GETTIME, CLOCK_MONOTONIC, (uint32_t)&ts);
+  }
+  abibench_report("clock_gettime", "register", rdtsc() - start);
+}
+
+// Round trips of the same syscalls with their arguments on the stack and in registers.
+// sysstat shows the part of each that is spent in the handler itself
+int main(int argc, char **argv)
+{
+  // Make sure the calls really work before timing them
+  struct timespec_t ts;
+  if (stack_call2(ABIBENCH_CLOCK_GETTIME, CLOCK_MONOTONIC, (uint32_t)&ts) < 0 ||
+      register_call2(ABIBENCH_CLOCK_GETTIME, CLOCK_MONOTONIC, (uint32_t)&ts) < 0)
+  {
+    printf("abibench: clock_gettime failed\n");
+    return -1;
+  }
+
+  abibench_getkey();
+  abibench_idle_stats();
+  abibench_clock_gettime();
+  return 0;
+}
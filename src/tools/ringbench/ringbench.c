@@ -0,0 +1,71 @@
+#include "os.h"
+#include "stdlib.h"
+#include "stdio.h"
+#include "ring.h"
+#include <stdint.h>
+
+// A power of two so the per call cost is a shift, there is no 64 bit division without libgcc
+#define RINGBENCH_CALLS_SHIFT 16
+#define RINGBENCH_CALLS (1 << RINGBENCH_CALLS_SHIFT)
+
+static inline uint64_t rdtsc()
+{
+  uint32_t low, high;
+  asm volatile("rdtsc" : "=a"(low), "=d"(high));
+  return ((uint64_t)high << 32) | low;
+}
+
+// getkey through the plain int 0x80 gate, it returns at once when no key is waiting
+static inline int int80_getkey()
+{
+  int res;
+  asm volatile("int $0x80" : "=a"(res) : "a"(0x80000000 | SYSCALL_RING_GETKEY) : "memory");
+  return res;
+}
+
+static void ringbench_report(const char *name, uint64_t cycles)
+{
+  printf("%s: %u cycles per call\n", name, (uint32_t)(cycles >> RINGBENCH_CALLS_SHIFT));
+}
+
+int main(int argc, char **argv)
+{
+  struct syscall_ring_t *ring = ring_init();
+  if (!ring)
+  {
+    printf("ringbench: could not map the syscall rings\n");
+    return -1;
+  }
+
+  uint64_t start = rdtsc();
+  for (int i = 0; i < RINGBENCH_CALLS; i++)
+  {
+    int80_getkey();
+  }
+  ringbench_report("int 0x80", rdtsc() - start);
+
+  start = rdtsc();
+  for (int i = 0; i < RINGBENCH_CALLS; i++)
+  {
+    sys_getkey();
+  }
+  ringbench_report("sysenter", rdtsc() - start);
+
+  struct syscall_ring_cqe_t cqe;
+  start = rdtsc();
+  for (int i = 0; i < RINGBENCH_CALLS; i += SYSCALL_RING_ENTRIES)
+  {
+    for (int j = 0; j < SYSCALL_RING_ENTRIES; j++)
+    {
+      ring_submit(ring, SYSCALL_RING_GETKEY, 0, j);
+    }
+
+    ring_flush(ring);
+    while (ring_complete(ring, &cqe))
+    {
+    }
+  }
+  ringbench_report("ring", rdtsc() - start);
+
+  return 0;
+}
@@ -0,0 +1,130 @@
+#include "os.h"
+#include "stdlib.h"
+#include "stdio.h"
+#include <stdint.h>
+
+#define SYSSTAT_COMMANDS 32
+#define SYSSTAT_PROCESSES 12
+
+static const char *sysstat_names[] = {
+    "print",
+    "getkey",
+    "putchar",
+    "malloc",
+    "free",
+    "process_load_start",
+    "system",
+    "get_program_arguments",
+    "exit",
+    "ring_setup",
+    "ring_enter",
+    "stats",
+    "nice",
+    "getkey_block",
+    "idle_stats",
+    "clock_gettime",
+    "sleep",
+    "sysenter_enabled",
+    "disk_cache_stats",
+};
+
+// 64 by 32 bit division by shift and subtract, there is no libgcc to do it for us
+static uint32_t sysstat_divide(uint64_t dividend, uint32_t divisor)
+{
+  uint64_t quotient = 0;
+  uint64_t remainder = 0;
+  for (int i = 63; i >= 0; i--)
+  {
+    remainder = (remainder << 1) | ((dividend >> i) & 1);
+    if (remainder >= divisor)
+    {
+      remainder -= divisor;
+      quotient |= (uint64_t)1 << i;
+    }
+  }
+
+  return (uint32_t)quotient;
+}
+
+static void sysstat_print(struct syscall_stats_t *stats, int total)
+{
+  for (int i = 0; i < total; i++)
+  {
+    if (!stats[i].calls)
+    {
+      continue;
+    }
+
+    const char *name = i < (int)(sizeof(sysstat_names) / sizeof(sysstat_names[0])) ? sysstat_names[i] : "unknown";
+    printf("  %d %s: %u calls, avg %u min %u max %u cycles\n", i, name, stats[i].calls,
+           sysstat_divide(stats[i].total_cycles, stats[i].calls), (uint32_t)stats[i].min_cycles, (uint32_t)stats[i].max_cycles);
+  }
+}
+
+// Print the share of time the idle task has been halted since boot
+static void sysstat_print_idle()
+{
+  struct idle_stats_t idle;
+  if (sys_idle_stats(&idle) < 0)
+  {
+    return;
+  }
+
+  // Scale both down until the total fits the 32 bit divisor
+  uint64_t total = idle.total_cycles;
+  uint64_t idle_cycles = idle.idle_cycles;
+  while (total >> 32)
+  {
+    total >>= 1;
+    idle_cycles >>= 1;
+  }
+
+  if (!total)
+  {
+    return;
+  }
+
+  printf("idle: %u percent\n", sysstat_divide(idle_cycles * 100, (uint32_t)total));
+}
+
+static void sysstat_print_disk_cache()
+{
+  struct disk_cache_stats_t cache;
+  if (sys_disk_cache_stats(&cache) < 0)
+  {
+    return;
+  }
+
+  printf("disk cache: %u hits, %u misses, %u evictions\n", cache.hits, cache.misses, cache.evictions);
+}
+
+int main(int argc, char **argv)
+{
+  sysstat_print_idle();
+  sysstat_print_disk_cache();
+
+  struct syscall_stats_t stats[SYSSTAT_COMMANDS];
+  int total = sys_stats(-1, stats, SYSSTAT_COMMANDS);
+  if (total <= 0)
+  {
+    printf("sysstat: syscall statistics are not available\n");
+    return -1;
+  }
+
+  printf("system:\n");
+  sysstat_print(stats, total);
+
+  for (int id = 0; id < SYSSTAT_PROCESSES; id++)
+  {
+    total = sys_stats(id, stats, SYSSTAT_COMMANDS);
+    if (total <= 0)
+    {
+      continue;
+    }
+
+    printf("process %d:\n", id);
+    sysstat_print(stats, total);
+  }
+
+  return 0;
+}